@@ -0,0 +1,45 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<size_t> allocations{0};
+}
+
+size_t allocationsCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *res = std::malloc(size ? size : 1))
+    {
+        return res;
+    }
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
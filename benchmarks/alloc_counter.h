@@ -0,0 +1,30 @@
+#ifndef __ALLOC_COUNTER_H__
+#define __ALLOC_COUNTER_H__
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+
+// Number of calls of the global operator new since the program start, the
+// operator is replaced in alloc_counter.cpp
+size_t allocationsCount();
+
+// Reports the allocations per iteration made since the construction
+class AllocationsCounter
+{
+  public:
+    AllocationsCounter(benchmark::State &state) : state_{state}, start_{allocationsCount()}
+    {
+    }
+    ~AllocationsCounter()
+    {
+        state_.counters["allocs"] = benchmark::Counter(static_cast<double>(allocationsCount() - start_),
+                                                       benchmark::Counter::kAvgIterations);
+    }
+
+  private:
+    benchmark::State &state_;
+    size_t start_;
+};
+
+#endif // __ALLOC_COUNTER_H__
@@ -0,0 +1,246 @@
+#include <Parsers/ListValue.h>
+#include <Parsers/Parser.h>
+#include <Parsers/TypedValue.h>
+#include <benchmark/benchmark.h>
+#include <boost/program_options/parsers.hpp>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace po = boost::program_options;
+using program_options_heavy::OptionsGroup;
+using program_options_heavy::Parser;
+
+namespace
+{
+
+struct Schema
+{
+    // groups_count groups with options_count options each, the parsed
+    // command line sets the first option of every group
+    Schema(size_t groups_count, size_t options_count, bool typed_values = false) : values(groups_count * options_count)
+    {
+        args.push_back("programname");
+        for (size_t g = 0; g < groups_count; g++)
+        {
+            auto group = std::make_shared<OptionsGroup>("group" + std::to_string(g));
+            for (size_t o = 0; o < options_count; o++)
+            {
+                std::string name = "group" + std::to_string(g) + "-option" + std::to_string(o);
+                size_t *value = &values[g * options_count + o];
+                if (typed_values)
+                {
+                    group->addPartialVisible(name.c_str(), program_options_heavy::typedValue(value), "option");
+                }
+                else
+                {
+                    group->addPartialVisible(name.c_str(), po::value<size_t>(value), "option");
+                }
+            }
+            parser.addGroup(group);
+            args.push_back("--group" + std::to_string(g) + "-option0");
+            args.push_back(std::to_string(g));
+        }
+        for (const auto &it : args)
+        {
+            argv.push_back(it.c_str());
+        }
+    }
+    Parser parser;
+    std::vector<size_t> values;
+    std::vector<std::string> args;
+    std::vector<const char *> argv;
+};
+
+void BM_ParserParse(benchmark::State &state)
+{
+    Schema schema(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        schema.parser.parse(static_cast<int>(schema.argv.size()), schema.argv.data());
+    }
+}
+BENCHMARK(BM_ParserParse)->Args({5, 10})->Args({20, 50})->Args({50, 100});
+
+// The same parse with the values converted by TypedValue
+void BM_ParserParseTypedValues(benchmark::State &state)
+{
+    Schema schema(state.range(0), state.range(1), true);
+    for (auto _ : state)
+    {
+        schema.parser.parse(static_cast<int>(schema.argv.size()), schema.argv.data());
+    }
+}
+BENCHMARK(BM_ParserParseTypedValues)->Args({5, 10})->Args({20, 50})->Args({50, 100});
+
+// Conversion of one token as po::store does it: po::value<T> against TypedValue<T>
+template <class T> std::string sampleToken()
+{
+    return std::is_floating_point_v<T> ? "0.000123" : "1234567";
+}
+template <class T> void BM_ValueConversionBoost(benchmark::State &state)
+{
+    std::unique_ptr<po::value_semantic> semantic(po::value<T>());
+    std::vector<std::string> tokens{sampleToken<T>()};
+    for (auto _ : state)
+    {
+        boost::any value;
+        semantic->parse(value, tokens, false);
+        benchmark::DoNotOptimize(value);
+    }
+}
+template <class T> void BM_ValueConversionTyped(benchmark::State &state)
+{
+    std::unique_ptr<po::value_semantic> semantic(program_options_heavy::typedValue<T>());
+    std::vector<std::string> tokens{sampleToken<T>()};
+    for (auto _ : state)
+    {
+        boost::any value;
+        semantic->parse(value, tokens, false);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK_TEMPLATE(BM_ValueConversionBoost, size_t);
+BENCHMARK_TEMPLATE(BM_ValueConversionTyped, size_t);
+BENCHMARK_TEMPLATE(BM_ValueConversionBoost, double);
+BENCHMARK_TEMPLATE(BM_ValueConversionTyped, double);
+
+// state.range(0) integers given as one comma separated token to ListValue
+// against the multitoken vector of po::value
+std::vector<std::string> integerTokens(size_t count)
+{
+    std::vector<std::string> res;
+    for (size_t n = 0; n < count; n++)
+    {
+        res.push_back(std::to_string(n * 40009));
+    }
+    return res;
+}
+void BM_ListValue(benchmark::State &state)
+{
+    std::vector<uint32_t> ids;
+    std::unique_ptr<po::value_semantic> semantic(program_options_heavy::listValue(&ids));
+    std::vector<std::string> tokens(1);
+    for (const auto &it : integerTokens(state.range(0)))
+    {
+        tokens[0] += (tokens[0].empty() ? "" : ",") + it;
+    }
+    for (auto _ : state)
+    {
+        boost::any value;
+        semantic->parse(value, tokens, false);
+        benchmark::DoNotOptimize(ids.data());
+    }
+    state.SetBytesProcessed(state.iterations() * tokens[0].size());
+}
+BENCHMARK(BM_ListValue)->Arg(1000)->Arg(100000);
+
+void BM_ListValueMultitoken(benchmark::State &state)
+{
+    std::vector<uint32_t> ids;
+    std::unique_ptr<po::value_semantic> semantic(po::value<std::vector<uint32_t>>(&ids)->multitoken());
+    std::vector<std::string> tokens = integerTokens(state.range(0));
+    size_t bytes = 0;
+    for (const auto &it : tokens)
+    {
+        bytes += it.size() + 1;
+    }
+    for (auto _ : state)
+    {
+        boost::any value;
+        semantic->parse(value, tokens, false);
+        semantic->notify(value);
+        benchmark::DoNotOptimize(ids.data());
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_ListValueMultitoken)->Arg(1000)->Arg(100000);
+
+// The same parse with options_description merged on every call (as Parser
+// did before the merged description was cached)
+void BM_ParserParseRebuildDescription(benchmark::State &state)
+{
+    Schema schema(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        po::options_description partial;
+        po::positional_options_description positional;
+        for (const auto &it : schema.parser.groups())
+        {
+            partial.add(it->partial);
+        }
+        po::variables_map vm;
+        po::store(po::command_line_parser(static_cast<int>(schema.argv.size()), schema.argv.data())
+                      .options(partial)
+                      .positional(positional)
+                      .run(),
+                  vm);
+        po::notify(vm);
+    }
+}
+BENCHMARK(BM_ParserParseRebuildDescription)->Args({5, 10})->Args({20, 50})->Args({50, 100});
+
+// Many positional arguments and a large inline value
+struct Inputs
+{
+    Inputs(size_t inputs_count, size_t value_size) : value(value_size, 'x')
+    {
+        auto group = std::make_shared<OptionsGroup>("group");
+        group->addPartialVisible("name", po::value<std::string>(&name), "option");
+        group->addPositionalVisible("input", -1, po::value<std::vector<std::string>>(&inputs), "inputs");
+        parser.addGroup(group);
+        args.push_back("programname");
+        args.push_back("--name");
+        args.push_back(value);
+        for (size_t n = 0; n < inputs_count; n++)
+        {
+            args.push_back("input" + std::to_string(n) + ".txt");
+        }
+        for (const auto &it : args)
+        {
+            argv.push_back(it.c_str());
+        }
+    }
+    Parser parser;
+    std::string value;
+    std::string name;
+    std::vector<std::string> inputs;
+    std::vector<std::string> args;
+    std::vector<const char *> argv;
+};
+
+void BM_ParserParseInputs(benchmark::State &state)
+{
+    Inputs inputs(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        inputs.parser.parse(static_cast<int>(inputs.argv.size()), inputs.argv.data());
+    }
+}
+BENCHMARK(BM_ParserParseInputs)->Args({10, 1 << 20})->Args({10000, 16});
+
+// The same command line tokenized by boost::program_options::command_line_parser
+void BM_ParserParseInputsBoost(benchmark::State &state)
+{
+    Inputs inputs(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        po::options_description partial;
+        for (const auto &it : inputs.parser.groups())
+        {
+            partial.add(it->partial);
+        }
+        po::variables_map vm;
+        po::store(po::command_line_parser(static_cast<int>(inputs.argv.size()), inputs.argv.data())
+                      .options(partial)
+                      .positional(inputs.parser.groups().front()->positional)
+                      .run(),
+                  vm);
+        po::notify(vm);
+    }
+}
+BENCHMARK(BM_ParserParseInputsBoost)->Args({10, 1 << 20})->Args({10000, 16});
+
+} // namespace
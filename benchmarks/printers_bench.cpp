@@ -0,0 +1,68 @@
+#include "alloc_counter.h"
+
+#include <Parsers/Parser.h>
+#include <Printers/PrettyPrinter.h>
+#include <Printers/ProgramOptionsPrinter.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+using program_options_heavy::OptionsGroup;
+using program_options_heavy::Parser;
+using program_options_heavy::printers::PrettyPrinter;
+using program_options_heavy::printers::ProgramOptionsPrinter;
+using program_options_heavy::printers::StringSink;
+
+namespace
+{
+
+struct HelpSchema
+{
+    HelpSchema(size_t groups_count, size_t options_count) : values(groups_count * options_count)
+    {
+        for (size_t g = 0; g < groups_count; g++)
+        {
+            auto group = std::make_shared<OptionsGroup>("group" + std::to_string(g));
+            group->description << "options of the group " << g;
+            for (size_t o = 0; o < options_count; o++)
+            {
+                std::string name = "group" + std::to_string(g) + "-option" + std::to_string(o);
+                group->addPartialVisible(name.c_str(), po::value<size_t>(&values[g * options_count + o]),
+                                         "some option with a description of a typical length");
+            }
+            parser.addGroup(group);
+        }
+    }
+    Parser parser;
+    std::vector<size_t> values;
+};
+
+void BM_HelpBuild(benchmark::State &state)
+{
+    HelpSchema schema(state.range(0), state.range(1));
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        ProgramOptionsPrinter printer;
+        benchmark::DoNotOptimize(printer.print(schema.parser));
+    }
+}
+BENCHMARK(BM_HelpBuild)->Args({10, 10})->Args({100, 50});
+
+void BM_HelpBuildAndRender(benchmark::State &state)
+{
+    HelpSchema schema(state.range(0), state.range(1));
+    std::string out;
+    PrettyPrinter pretty(std::make_shared<StringSink>(out), PrettyPrinter::ColorMode::Never);
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        ProgramOptionsPrinter printer;
+        benchmark::DoNotOptimize(pretty.render(printer.print(schema.parser)).size());
+    }
+}
+BENCHMARK(BM_HelpBuildAndRender)->Args({10, 10})->Args({100, 50});
+
+} // namespace
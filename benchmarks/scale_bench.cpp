@@ -0,0 +1,146 @@
+#include "alloc_counter.h"
+#include "schema_generator.h"
+
+#include <Printers/PrettyPrinter.h>
+#include <Printers/ProgramOptionsPrinter.h>
+#include <Printers/ProgramSubcommandsPrinter.h>
+#include <benchmark/benchmark.h>
+#include <completer.h>
+
+#include <string>
+#include <vector>
+
+using program_options_heavy::Completer;
+using program_options_heavy::printers::PrettyPrinter;
+using program_options_heavy::printers::ProgramOptionsPrinter;
+using program_options_heavy::printers::ProgramSubcommandsPrinter;
+using program_options_heavy::printers::StringSink;
+
+// The whole tool at scale: Args({subcommands, options per subcommand}). Run
+// with --benchmark_format=json (or --benchmark_out=results.json
+// --benchmark_out_format=json) to keep the results for the comparison with
+// tools/compare.py from Google Benchmark.
+
+namespace
+{
+
+// Parsing of the command lines selecting different subcommands, 10 options are set
+void BM_ScaleSubcommandsParse(benchmark::State &state)
+{
+    SchemaGenerator schema(state.range(0), state.range(1));
+    std::vector<Argv> argvs;
+    for (size_t n = 0; n < 16; n++)
+    {
+        argvs.emplace_back(schema.commandLine(n * 7919 % state.range(0), state.range(1), state.range(1) / 10));
+    }
+    size_t n = 0;
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        Argv &argv = argvs[n++ % argvs.size()];
+        schema.parser->parse(argv.argc(), argv.data());
+    }
+}
+BENCHMARK(BM_ScaleSubcommandsParse)->Args({10, 50})->Args({1000, 50})->Unit(benchmark::kMicrosecond);
+
+// Parser of the single subcommand, every option is set
+void BM_ScaleParserParse(benchmark::State &state)
+{
+    SchemaGenerator schema(state.range(0), state.range(1));
+    auto parser = (*schema.parser)[SchemaGenerator::subcommandName(0)];
+    auto args = schema.commandLine(0, state.range(1));
+    args.erase(args.begin() + 1); // the subcommand name
+    Argv argv(std::move(args));
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        parser->parse(argv.argc(), argv.data());
+    }
+}
+BENCHMARK(BM_ScaleParserParse)->Args({1, 50})->Args({1, 500})->Unit(benchmark::kMicrosecond);
+
+void BM_ScaleCompleterConstruct(benchmark::State &state)
+{
+    SchemaGenerator schema(state.range(0), state.range(1));
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        Completer completer(schema.parser);
+        benchmark::DoNotOptimize(completer);
+    }
+}
+BENCHMARK(BM_ScaleCompleterConstruct)->Args({10, 50})->Args({1000, 50})->Unit(benchmark::kMillisecond);
+
+void BM_ScaleCompleteSubcommand(benchmark::State &state)
+{
+    SchemaGenerator schema(state.range(0), state.range(1));
+    Completer completer(schema.parser);
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(completer.getCompletionVariants("programname subcommand12"));
+    }
+}
+BENCHMARK(BM_ScaleCompleteSubcommand)->Args({10, 50})->Args({1000, 50});
+
+void BM_ScaleCompleteOption(benchmark::State &state)
+{
+    SchemaGenerator schema(state.range(0), state.range(1));
+    Completer completer(schema.parser);
+    std::string line = "programname " + SchemaGenerator::subcommandName(state.range(0) / 2) + " --option1 x --option2";
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(completer.getCompletionVariants(line));
+    }
+}
+BENCHMARK(BM_ScaleCompleteOption)->Args({10, 50})->Args({1000, 50});
+
+// Help for all the subcommands, built and rendered
+void BM_ScaleSubcommandsHelp(benchmark::State &state)
+{
+    SchemaGenerator schema(state.range(0), state.range(1));
+    std::string out;
+    PrettyPrinter pretty(std::make_shared<StringSink>(out), PrettyPrinter::ColorMode::Never);
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        ProgramSubcommandsPrinter printer;
+        benchmark::DoNotOptimize(pretty.render(printer.print(*schema.parser)).size());
+    }
+}
+BENCHMARK(BM_ScaleSubcommandsHelp)->Args({10, 50})->Args({1000, 50})->Unit(benchmark::kMillisecond);
+
+// Help for a single subcommand of the large tool, the printer cache is off
+void BM_ScaleSubcommandHelp(benchmark::State &state)
+{
+    SchemaGenerator schema(state.range(0), state.range(1));
+    std::string out;
+    PrettyPrinter pretty(std::make_shared<StringSink>(out), PrettyPrinter::ColorMode::Never);
+    ProgramSubcommandsPrinter printer;
+    std::string name = SchemaGenerator::subcommandName(state.range(0) / 2);
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        printer.clearCache();
+        benchmark::DoNotOptimize(pretty.render(printer.print(*schema.parser, name)).size());
+    }
+}
+BENCHMARK(BM_ScaleSubcommandHelp)->Args({10, 50})->Args({1000, 50})->Unit(benchmark::kMicrosecond);
+
+void BM_ScaleProgramOptionsHelp(benchmark::State &state)
+{
+    SchemaGenerator schema(state.range(0), state.range(1));
+    auto parser = (*schema.parser)[SchemaGenerator::subcommandName(0)];
+    std::string out;
+    PrettyPrinter pretty(std::make_shared<StringSink>(out), PrettyPrinter::ColorMode::Never);
+    AllocationsCounter allocs(state);
+    for (auto _ : state)
+    {
+        ProgramOptionsPrinter printer;
+        benchmark::DoNotOptimize(pretty.render(printer.print(*parser)).size());
+    }
+}
+BENCHMARK(BM_ScaleProgramOptionsHelp)->Args({1, 50})->Args({1, 500})->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,139 @@
+#ifndef __SCHEMA_GENERATOR_H__
+#define __SCHEMA_GENERATOR_H__
+
+#include <Parsers/ParserWithSubcommands.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Synthetic options schema of a large tool: subcommands_count subcommands
+// with options_count options each, the options are split into groups of
+// group_size and every subcommand shares the common group. The options have
+// a mix of value types, some of the first ones have short names. The values are
+// bound to the storage kept here, so the schema must outlive the parsers.
+class SchemaGenerator
+{
+  public:
+    static constexpr size_t group_size = 10;
+
+    SchemaGenerator(size_t subcommands_count, size_t options_count)
+        : parser{std::make_shared<program_options_heavy::ParserWithSubcommands>("programname")}
+    {
+        namespace po = boost::program_options;
+        common_ = std::make_shared<program_options_heavy::OptionsGroup>("common options");
+        common_->addPartialVisible("verbose,v", po::bool_switch(&flag(false)), "print more details");
+        common_->addPartialVisible("threads,j", po::value<size_t>(&number(1)), "number of worker threads");
+        for (size_t s = 0; s < subcommands_count; s++)
+        {
+            auto subcommand = (*parser)[subcommandName(s)];
+            for (size_t first = 0; first < options_count; first += group_size)
+            {
+                auto group = std::make_shared<program_options_heavy::OptionsGroup>(
+                    subcommandName(s) + " options " + std::to_string(first / group_size));
+                group->description << "options of the subcommand " << s;
+                for (size_t o = first; o < std::min(options_count, first + group_size); o++)
+                {
+                    std::string name = optionName(o);
+                    if (o % 5 == 0 && o / 5 < 8) // -a..-h, not clashing with the common options
+                    {
+                        name += ",";
+                        name += static_cast<char>('a' + o / 5);
+                    }
+                    const char *description = "some option with a description of a typical length";
+                    switch (o % 3)
+                    {
+                    case 0:
+                        group->addPartialVisible(name.c_str(), po::value<size_t>(&number(0)), description);
+                        break;
+                    case 1:
+                        group->addPartialVisible(name.c_str(), po::value<std::string>(&string()), description);
+                        break;
+                    default:
+                        group->addPartialVisible(name.c_str(), po::bool_switch(&flag(false)), description);
+                        break;
+                    }
+                }
+                subcommand->addGroup(group);
+            }
+            subcommand->addGroup(common_);
+        }
+    }
+
+    static std::string subcommandName(size_t n)
+    {
+        return "subcommand" + std::to_string(n);
+    }
+    static std::string optionName(size_t n)
+    {
+        return "option" + std::to_string(n);
+    }
+
+    // Command line of the subcommand which sets every step-th option
+    std::vector<std::string> commandLine(size_t subcommand, size_t options_count, size_t step = 1) const
+    {
+        std::vector<std::string> res{"programname", subcommandName(subcommand), "-v", "--threads", "4"};
+        for (size_t o = 0; o < options_count; o += step)
+        {
+            res.push_back("--" + optionName(o));
+            switch (o % 3)
+            {
+            case 0:
+                res.push_back(std::to_string(o));
+                break;
+            case 1:
+                res.push_back("value" + std::to_string(o));
+                break;
+            }
+        }
+        return res;
+    }
+
+    std::shared_ptr<program_options_heavy::ParserWithSubcommands> parser;
+
+  private:
+    std::shared_ptr<program_options_heavy::OptionsGroup> common_;
+    // deque keeps the addresses of the bound values
+    std::deque<size_t> numbers_;
+    std::deque<std::string> strings_;
+    std::deque<bool> flags_;
+
+    size_t &number(size_t value)
+    {
+        return numbers_.emplace_back(value);
+    }
+    std::string &string()
+    {
+        return strings_.emplace_back();
+    }
+    bool &flag(bool value)
+    {
+        return flags_.emplace_back(value);
+    }
+};
+
+// argv view of the command line
+struct Argv
+{
+    Argv(std::vector<std::string> args) : args{std::move(args)}
+    {
+        for (const auto &it : this->args)
+        {
+            argv.push_back(it.c_str());
+        }
+    }
+    int argc() const
+    {
+        return static_cast<int>(argv.size());
+    }
+    const char **data()
+    {
+        return argv.data();
+    }
+    std::vector<std::string> args;
+    std::vector<const char *> argv;
+};
+
+#endif // __SCHEMA_GENERATOR_H__
@@ -11,6 +11,18 @@ using program_options_heavy::Completer;
 
 int main() {
     namespace po = boost::program_options;
+    // fast path: ask the resident server or answer from the on-disk index
+    // without building the parsers
+    auto cached = Completer::completeFromServer();
+    if(!cached.has_value())
+        cached = Completer::completeFromCache();
+    if(cached.has_value()) {
+        for(const auto& it : cached.value()) {
+            std::cout<<it<<"\n";
+        }
+        return 0;
+    }
+
     auto commands_parser = std::make_shared<ParserWithSubcommands>("completer");
     auto runOptions = std::make_shared<OptionsGroup>("run group");
     size_t dim;
@@ -34,6 +46,9 @@ int main() {
     //commands_parser->"run"
 
     Completer completer(commands_parser);
+    completer.saveCache();
+    if(getenv("COMP_LINE"))
+        completer.spawnServer();
     std::vector<std::string> variants = completer.getCompletionVariants();
     for(const auto& it : variants) {
         std::cout<<it<<"\n";
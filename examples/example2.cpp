@@ -23,7 +23,9 @@ int main(int argc, const char* argv[]) {
     subcommands_parser["gather"]->addGroup(commonOptions);
 
     ProgramSubcommandsPrinter printer;
-    auto dom = printer.print(subcommands_parser);
+    // "example2 run" prints the help for the run subcommand only
+    auto dom = argc > 1 && subcommands_parser.contains(argv[1]) ? printer.print(subcommands_parser, argv[1])
+                                                                : printer.print(subcommands_parser);
 
     PrettyPrinter pp;
     dom->accept(pp);
@@ -0,0 +1,323 @@
+#ifndef __COMPLETION_CACHE_H__
+#define __COMPLETION_CACHE_H__
+
+#include <Completion/CompletionIndex.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace program_options_heavy
+{
+
+namespace completion
+{
+
+struct ExecutableIdentity
+{
+    // The cache becomes stale as soon as the executable is rebuilt
+    uint64_t size{0};
+    int64_t mtime_ns{0};
+    uint64_t schema_hash{0}; // optional user-defined version of the options schema
+
+    bool operator==(const ExecutableIdentity &) const = default;
+
+    static std::optional<ExecutableIdentity> current(uint64_t schema_hash = 0)
+    {
+        struct stat st;
+        if (stat("/proc/self/exe", &st) != 0)
+        {
+            return std::nullopt;
+        }
+        ExecutableIdentity res;
+        res.size = static_cast<uint64_t>(st.st_size);
+        res.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        res.schema_hash = schema_hash;
+        return res;
+    }
+};
+
+class CompletionCache
+{
+    // Stores CompletionIndex in a binary file: the header is followed by the
+    // tables of the index as is, so loading is just mmap of the file. No
+    // parser objects are needed to answer the completion request from the
+    // cache.
+  public:
+    static constexpr char magic[8] = {'P', 'O', 'H', 'C', 'I', 'D', 'X', '\0'};
+    static constexpr uint32_t version = 1;
+    // Header::flags
+    static constexpr uint32_t values_omitted = 1; // the schema has value completers, the cache can't store them
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        uint64_t exe_size;
+        int64_t exe_mtime_ns;
+        uint64_t schema_hash;
+        CompletionIndex::StringRef exename;
+        uint32_t pool_size; // padded to 4 bytes
+        uint32_t commands_count;
+        uint32_t command_entries_count;
+        uint32_t option_entries_count;
+        uint32_t canonical_count;
+        uint32_t flags;
+    };
+
+    CompletionCache(std::filesystem::path path = defaultPath()) : path_{std::move(path)}
+    {
+    }
+
+    const std::filesystem::path &path() const
+    {
+        return path_;
+    }
+
+    // $XDG_CACHE_HOME/program_options_heavy/<exename>-<hash of the executable path>.idx
+    static std::filesystem::path defaultPath()
+    {
+        std::filesystem::path dir;
+        if (const char *xdg = getenv("XDG_CACHE_HOME"); xdg && *xdg)
+        {
+            dir = xdg;
+        }
+        else if (const char *home = getenv("HOME"); home && *home)
+        {
+            dir = std::filesystem::path(home) / ".cache";
+        }
+        else
+        {
+            dir = std::filesystem::temp_directory_path();
+        }
+        std::error_code ec;
+        auto exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+        std::string name = exe.filename().string();
+        if (name.empty())
+        {
+            name = "unknown";
+        }
+        std::stringstream str;
+        str << name << "-" << std::hex << std::hash<std::string>{}(exe.string()) << ".idx";
+        return dir / "program_options_heavy" / str.str();
+    }
+
+    // Writes the index atomically (temporary file + rename), returns false on
+    // any io error: the cache is an optimization only
+    bool save(const CompletionIndex &index, const ExecutableIdentity &identity, uint32_t flags = 0) const
+    {
+        auto t = index.tables();
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.header_size = sizeof(Header);
+        header.exe_size = identity.size;
+        header.exe_mtime_ns = identity.mtime_ns;
+        header.schema_hash = identity.schema_hash;
+        header.exename = t.exename;
+        header.pool_size = static_cast<uint32_t>(align(t.pool.size()));
+        header.commands_count = static_cast<uint32_t>(t.commands.size());
+        header.command_entries_count = static_cast<uint32_t>(t.command_entries.size());
+        header.option_entries_count = static_cast<uint32_t>(t.option_entries.size());
+        header.canonical_count = static_cast<uint32_t>(t.canonical.size());
+        header.flags = flags;
+
+        std::string data(reinterpret_cast<const char *>(&header), sizeof(header));
+        data.append(t.pool);
+        data.resize(sizeof(header) + header.pool_size, '\0');
+        append(data, t.commands);
+        append(data, t.command_entries);
+        append(data, t.option_entries);
+        append(data, t.canonical);
+
+        std::error_code ec;
+        std::filesystem::create_directories(path_.parent_path(), ec);
+        auto tmp = path_;
+        tmp += "." + std::to_string(getpid()) + ".tmp";
+        int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return false;
+        }
+        bool ok = writeAll(fd, data);
+        ok = (close(fd) == 0) && ok;
+        if (ok && rename(tmp.c_str(), path_.c_str()) == 0)
+        {
+            return true;
+        }
+        unlink(tmp.c_str());
+        return false;
+    }
+
+    // Maps the cache file, returns nullopt if the file is missing, corrupted or
+    // was written by another build of the executable. The flags given to
+    // save() are returned in flags.
+    std::optional<CompletionIndex> load(const ExecutableIdentity &identity, uint32_t *flags = nullptr) const
+    {
+        int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header))
+        {
+            close(fd);
+            return std::nullopt;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED)
+        {
+            return std::nullopt;
+        }
+        std::shared_ptr<const void> storage(addr, [size](const void *p) { munmap(const_cast<void *>(p), size); });
+
+        const char *base = static_cast<const char *>(addr);
+        const Header &header = *reinterpret_cast<const Header *>(base);
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+            header.header_size != sizeof(Header))
+        {
+            return std::nullopt;
+        }
+        if (ExecutableIdentity{header.exe_size, header.exe_mtime_ns, header.schema_hash} != identity)
+        {
+            return std::nullopt;
+        }
+        // Counted in 64 bits table by table: the counts come from the file, so
+        // neither their sum nor a table past the end of the mapping is trusted
+        uint64_t expected = sizeof(Header);
+        auto fits = [&expected, size](uint64_t count, uint64_t item_size) {
+            expected += count * item_size;
+            return expected <= size;
+        };
+        if (!fits(header.pool_size, 1) || !fits(header.commands_count, sizeof(CompletionIndex::Command)) ||
+            !fits(header.command_entries_count, sizeof(CompletionIndex::Entry)) ||
+            !fits(header.option_entries_count, sizeof(CompletionIndex::Entry)) ||
+            !fits(header.canonical_count, sizeof(CompletionIndex::StringRef)) || expected != size)
+        {
+            return std::nullopt;
+        }
+
+        CompletionIndex::Tables t;
+        const char *pos = base + sizeof(Header);
+        t.exename = header.exename;
+        t.pool = std::string_view(pos, header.pool_size);
+        pos += header.pool_size;
+        t.commands = take<CompletionIndex::Command>(pos, header.commands_count);
+        t.command_entries = take<CompletionIndex::Entry>(pos, header.command_entries_count);
+        t.option_entries = take<CompletionIndex::Entry>(pos, header.option_entries_count);
+        t.canonical = take<CompletionIndex::StringRef>(pos, header.canonical_count);
+        if (!isConsistent(t))
+        {
+            return std::nullopt;
+        }
+        if (flags)
+        {
+            *flags = header.flags;
+        }
+        return CompletionIndex(t, std::move(storage));
+    }
+
+  private:
+    std::filesystem::path path_;
+
+    // All the references of the mapped tables point inside the tables, so a
+    // corrupted file of the right size can't make the index read out of
+    // bounds. Checked once per load, the lookups trust the tables.
+    static bool isConsistent(const CompletionIndex::Tables &t)
+    {
+        auto in_pool = [&t](uint32_t offset, uint32_t length) {
+            return uint64_t(offset) + length <= t.pool.size();
+        };
+        auto in_range = [](uint32_t first, uint32_t count, size_t size) { return uint64_t(first) + count <= size; };
+        if (!in_pool(t.exename.offset, t.exename.length))
+        {
+            return false;
+        }
+        for (const auto &cmd : t.commands)
+        {
+            if (!in_pool(cmd.name.offset, cmd.name.length) ||
+                !in_range(cmd.first_entry, cmd.entries_count, t.option_entries.size()) ||
+                !in_range(cmd.first_option, cmd.options_count, t.canonical.size()))
+            {
+                return false;
+            }
+            for (const auto &entry : t.option_entries.subspan(cmd.first_entry, cmd.entries_count))
+            {
+                if (!in_pool(entry.offset, entry.length) || entry.item >= cmd.options_count)
+                {
+                    return false;
+                }
+            }
+        }
+        for (const auto &entry : t.command_entries)
+        {
+            if (!in_pool(entry.offset, entry.length) || entry.item >= t.commands.size())
+            {
+                return false;
+            }
+        }
+        for (const auto &ref : t.canonical)
+        {
+            if (!in_pool(ref.offset, ref.length))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static size_t align(size_t n)
+    {
+        return (n + 3) & ~size_t(3);
+    }
+    template <class T> static void append(std::string &data, std::span<const T> items)
+    {
+        data.append(reinterpret_cast<const char *>(items.data()), items.size_bytes());
+    }
+    template <class T> static std::span<const T> take(const char *&pos, size_t count)
+    {
+        std::span<const T> res(reinterpret_cast<const T *>(pos), count);
+        pos += res.size_bytes();
+        return res;
+    }
+    static bool writeAll(int fd, std::string_view data)
+    {
+        while (!data.empty())
+        {
+            ssize_t n = write(fd, data.data(), data.size());
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+        return true;
+    }
+};
+
+} /* namespace completion */
+
+} /* namespace program_options_heavy */
+
+#endif // __COMPLETION_CACHE_H__
@@ -0,0 +1,222 @@
+#ifndef __COMPLETION_INDEX_H__
+#define __COMPLETION_INDEX_H__
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+namespace completion
+{
+
+class CompletionIndex
+{
+    // Compact completion index: all the names are stored in a single string
+    // pool, the names of the commands and the names of the options of every
+    // command are kept in sorted arrays. Hence all the names starting with the
+    // given prefix form a contiguous range which is found by binary search.
+    //
+    // The tables consist of plain integers only, so the index can be either
+    // built in memory or mapped from the file written by CompletionCache.
+  public:
+    struct Entry
+    {
+        uint32_t offset; // position of the name in the string pool
+        uint32_t length;
+        uint32_t item; // index of the command or index of the option within the command
+        uint32_t rank; // position of the name in the list of names of the same option
+    };
+    struct StringRef
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+    struct Command
+    {
+        StringRef name;
+        uint32_t first_entry; // range of names in option_entries
+        uint32_t entries_count;
+        uint32_t first_option; // range of canonical names in canonical
+        uint32_t options_count;
+    };
+    struct Tables
+    {
+        StringRef exename;
+        std::string_view pool;
+        std::span<const Command> commands;
+        std::span<const Entry> command_entries; // sorted names of the commands
+        std::span<const Entry> option_entries;  // sorted names of the options, grouped by commands
+        std::span<const StringRef> canonical;   // canonical names of the options, grouped by commands
+    };
+
+    CompletionIndex(const std::string &exename = "") : exename_{addString(exename)}
+    {
+    }
+    // Index over the tables owned by somebody else (e.g. over a mapped file),
+    // the storage is kept alive by the index
+    CompletionIndex(const Tables &tables, std::shared_ptr<const void> storage)
+        : external_{tables}, storage_{std::move(storage)}
+    {
+    }
+
+    // options[n] is the list of all the names of the n-th option, the first
+    // name is treated as canonical one
+    void addCommand(const std::string &name, const std::vector<std::vector<std::string>> &options)
+    {
+        add(name, options);
+    }
+    // The same over the names kept elsewhere, e.g. in OptionsSchema
+    void addCommand(std::string_view name, std::span<const std::span<const std::string_view>> options)
+    {
+        add(name, options);
+    }
+
+    Tables tables() const
+    {
+        if (storage_)
+        {
+            return external_;
+        }
+        return {exename_, std::string_view(pool_.data(), pool_.size()), commands_, command_entries_, option_entries_,
+                canonical_};
+    }
+
+    std::string_view exename() const
+    {
+        auto t = tables();
+        return str(t, t.exename);
+    }
+    size_t commandsCount() const
+    {
+        return tables().commands.size();
+    }
+    std::string_view commandName(uint32_t command) const
+    {
+        auto t = tables();
+        return str(t, t.commands[command].name);
+    }
+    uint32_t optionsCount(uint32_t command) const
+    {
+        return tables().commands[command].options_count;
+    }
+    std::string_view canonicalName(uint32_t command, uint32_t option) const
+    {
+        auto t = tables();
+        return str(t, t.canonical[t.commands[command].first_option + option]);
+    }
+
+    // All the command names starting with prefix, sorted by name
+    std::span<const Entry> commandNames(std::string_view prefix) const
+    {
+        auto t = tables();
+        return prefixRange(t, t.command_entries, prefix);
+    }
+    // All the option names of the command starting with prefix, sorted by name
+    std::span<const Entry> optionNames(uint32_t command, std::string_view prefix) const
+    {
+        auto t = tables();
+        const Command &cmd = t.commands[command];
+        return prefixRange(t, t.option_entries.subspan(cmd.first_entry, cmd.entries_count), prefix);
+    }
+    std::string_view str(const Entry &entry) const
+    {
+        return tables().pool.substr(entry.offset, entry.length);
+    }
+
+    // FNV-1a hash of all the tables, identifies the options schema
+    uint64_t hash() const
+    {
+        auto t = tables();
+        uint64_t res = 14695981039346656037ull;
+        auto mix = [&res](const void *data, size_t size) {
+            auto bytes = static_cast<const unsigned char *>(data);
+            for (size_t n = 0; n < size; n++)
+            {
+                res = (res ^ bytes[n]) * 1099511628211ull;
+            }
+        };
+        mix(&t.exename, sizeof(t.exename));
+        auto pool = t.pool.substr(0, t.pool.find_last_not_of('\0') + 1); // the mapped pool is padded with zeros
+        mix(pool.data(), pool.size());
+        mix(t.commands.data(), t.commands.size_bytes());
+        mix(t.command_entries.data(), t.command_entries.size_bytes());
+        mix(t.option_entries.data(), t.option_entries.size_bytes());
+        mix(t.canonical.data(), t.canonical.size_bytes());
+        return res;
+    }
+
+  private:
+    std::vector<char> pool_;
+    StringRef exename_{0, 0};
+    std::vector<Command> commands_;
+    std::vector<Entry> command_entries_;
+    std::vector<Entry> option_entries_;
+    std::vector<StringRef> canonical_;
+
+    Tables external_;
+    std::shared_ptr<const void> storage_;
+
+    template <class Options> void add(std::string_view name, const Options &options)
+    {
+        assert(!storage_); // external tables are read-only
+        Command cmd;
+        cmd.name = addString(name);
+        cmd.first_entry = static_cast<uint32_t>(option_entries_.size());
+        cmd.first_option = static_cast<uint32_t>(canonical_.size());
+        cmd.options_count = static_cast<uint32_t>(options.size());
+        for (uint32_t n = 0; n < options.size(); n++)
+        {
+            assert(!options[n].empty());
+            canonical_.push_back(addString(options[n].front()));
+            for (uint32_t rank = 0; rank < options[n].size(); rank++)
+            {
+                auto ref = addString(options[n][rank]);
+                option_entries_.push_back({ref.offset, ref.length, n, rank});
+            }
+        }
+        cmd.entries_count = static_cast<uint32_t>(option_entries_.size()) - cmd.first_entry;
+        auto begin = option_entries_.begin() + cmd.first_entry;
+        std::stable_sort(begin, option_entries_.end(), [this](const Entry &a, const Entry &b) { return str(a) < str(b); });
+
+        Entry entry{cmd.name.offset, cmd.name.length, static_cast<uint32_t>(commands_.size()), 0};
+        commands_.push_back(cmd);
+        auto pos = std::upper_bound(command_entries_.begin(), command_entries_.end(), entry,
+                                    [this](const Entry &a, const Entry &b) { return str(a) < str(b); });
+        command_entries_.insert(pos, entry);
+    }
+    StringRef addString(std::string_view s)
+    {
+        StringRef ref{static_cast<uint32_t>(pool_.size()), static_cast<uint32_t>(s.size())};
+        pool_.insert(pool_.end(), s.begin(), s.end());
+        return ref;
+    }
+    static std::string_view str(const Tables &t, const StringRef &ref)
+    {
+        return t.pool.substr(ref.offset, ref.length);
+    }
+    static std::string_view str(const Tables &t, const Entry &entry)
+    {
+        return t.pool.substr(entry.offset, entry.length);
+    }
+    static std::span<const Entry> prefixRange(const Tables &t, std::span<const Entry> entries, std::string_view prefix)
+    {
+        auto first = std::lower_bound(entries.begin(), entries.end(), prefix,
+                                      [&t](const Entry &e, std::string_view p) { return str(t, e) < p; });
+        auto last = std::partition_point(first, entries.end(),
+                                         [&t, prefix](const Entry &e) { return str(t, e).starts_with(prefix); });
+        return entries.subspan(first - entries.begin(), last - first);
+    }
+};
+
+} /* namespace completion */
+
+} /* namespace program_options_heavy */
+
+#endif // __COMPLETION_INDEX_H__
@@ -0,0 +1,506 @@
+#ifndef __COMPLETION_SERVER_H__
+#define __COMPLETION_SERVER_H__
+
+#include <Completion/CompletionCache.h>
+
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace program_options_heavy
+{
+
+namespace completion
+{
+
+// Protocol (one request per connection):
+//   request:  "POHC1 <schema hash in hex or ->\n<COMP_POINT>\n<COMP_LINE>"
+//   response: "OK\n" followed by the completion variants, one per line,
+//             or "STALE\n" if the server was built with another schema
+//             (the server exits after this response)
+// The hash "-" disables the handshake, it is used by the bash client which
+// knows nothing about the schema. In this case the server still checks that
+// its executable has not been rebuilt since the start.
+class CompletionProtocol
+{
+  public:
+    static constexpr std::string_view tag = "POHC1";
+    static constexpr size_t max_request_size = 1 << 16;
+
+    struct Request
+    {
+        std::optional<uint64_t> schema_hash;
+        std::string line; // COMP_LINE truncated to COMP_POINT
+    };
+
+    static std::string formatRequest(std::optional<uint64_t> schema_hash, std::string_view line,
+                                     std::optional<size_t> point)
+    {
+        std::stringstream str;
+        str << tag << " ";
+        if (schema_hash.has_value())
+        {
+            str << std::hex << schema_hash.value() << std::dec;
+        }
+        else
+        {
+            str << "-";
+        }
+        str << "\n";
+        if (point.has_value())
+        {
+            str << point.value();
+        }
+        str << "\n" << line;
+        return str.str();
+    }
+
+    static std::optional<Request> parseRequest(std::string_view data)
+    {
+        auto eol1 = data.find('\n');
+        if (eol1 == std::string_view::npos)
+        {
+            return std::nullopt;
+        }
+        auto eol2 = data.find('\n', eol1 + 1);
+        if (eol2 == std::string_view::npos)
+        {
+            return std::nullopt;
+        }
+        std::string_view head = data.substr(0, eol1);
+        std::string_view point = data.substr(eol1 + 1, eol2 - eol1 - 1);
+        std::string_view line = data.substr(eol2 + 1);
+        if (!head.starts_with(tag) || head.size() < tag.size() + 2 || head[tag.size()] != ' ')
+        {
+            return std::nullopt;
+        }
+        Request res;
+        std::string hash(head.substr(tag.size() + 1));
+        if (hash != "-")
+        {
+            char *end = nullptr;
+            res.schema_hash = std::strtoull(hash.c_str(), &end, 16);
+            if (*end != '\0')
+            {
+                return std::nullopt;
+            }
+        }
+        line = lineToPoint(line, point);
+        while (!line.empty() && line.back() == '\n')
+        {
+            line.remove_suffix(1);
+        }
+        res.line = line;
+        return res;
+    }
+
+    // COMP_LINE up to the cursor. COMP_POINT counts characters, not bytes,
+    // so the line is cut after that many UTF-8 code points; an empty,
+    // invalid or too large point keeps the whole line.
+    static std::string_view lineToPoint(std::string_view line, std::string_view point)
+    {
+        size_t count = 0;
+        auto [end, ec] = std::from_chars(point.data(), point.data() + point.size(), count);
+        if (point.empty() || ec != std::errc() || end != point.data() + point.size())
+        {
+            return line;
+        }
+        size_t pos = 0;
+        for (; pos < line.size() && count > 0; count--)
+        {
+            pos++;
+            while (pos < line.size() && (static_cast<unsigned char>(line[pos]) & 0xC0) == 0x80)
+            {
+                pos++; // continuation bytes of the character
+            }
+        }
+        return line.substr(0, pos);
+    }
+
+    // $XDG_RUNTIME_DIR/program_options_heavy-<exename>-<hash of the executable path>.sock,
+    // /tmp/program_options_heavy-<uid>/... if XDG_RUNTIME_DIR is not set,
+    // see also bash/_mycompleter. The builds of the same program in
+    // different places get their own servers.
+    static std::filesystem::path defaultSocketPath()
+    {
+        std::error_code ec;
+        auto exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+        std::filesystem::path dir;
+        if (const char *runtime = getenv("XDG_RUNTIME_DIR"); runtime && *runtime)
+        {
+            dir = runtime;
+        }
+        else
+        {
+            dir = "/tmp/program_options_heavy-" + std::to_string(getuid());
+        }
+        std::stringstream str;
+        str << "program_options_heavy-" << exe.filename().string() << "-" << std::hex << pathHash(exe.string())
+            << ".sock";
+        return dir / str.str();
+    }
+
+    // FNV-1a, simple enough to be repeated by the bash client
+    static uint64_t pathHash(std::string_view path)
+    {
+        uint64_t res = 14695981039346656037ull;
+        for (char ch : path)
+        {
+            res = (res ^ static_cast<unsigned char>(ch)) * 1099511628211ull;
+        }
+        return res;
+    }
+
+    // Creates the directory of the socket if needed. The directory must be a
+    // real directory of the current user inaccessible for the others, so
+    // nobody else can replace the socket.
+    static bool preparePrivateDirectory(const std::filesystem::path &dir)
+    {
+        if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST)
+        {
+            return false;
+        }
+        struct stat st;
+        return lstat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == getuid() &&
+               (st.st_mode & 0077) == 0;
+    }
+
+    // The process on the other end of the socket runs as the current user
+    static bool isPeerTrusted(int fd)
+    {
+        ucred cred;
+        socklen_t len = sizeof(cred);
+        return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid();
+    }
+
+    static bool writeAll(int fd, std::string_view data)
+    {
+        while (!data.empty())
+        {
+            ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+        return true;
+    }
+    // Reads until EOF, returns false on error, timeout or too long message
+    static bool readAll(int fd, std::string &data, int timeout_ms, size_t max_size = max_request_size)
+    {
+        char buf[4096];
+        while (true)
+        {
+            pollfd pfd{fd, POLLIN, 0};
+            int ready = poll(&pfd, 1, timeout_ms);
+            if (ready < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (ready <= 0)
+            {
+                return false;
+            }
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n < 0)
+            {
+                return false;
+            }
+            if (n == 0)
+            {
+                return true;
+            }
+            data.append(buf, static_cast<size_t>(n));
+            if (data.size() > max_size)
+            {
+                return false;
+            }
+        }
+    }
+    static int connectTo(const std::filesystem::path &path)
+    {
+        sockaddr_un addr;
+        if (!makeAddress(path, addr))
+        {
+            return -1;
+        }
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || !isPeerTrusted(fd))
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    static bool makeAddress(const std::filesystem::path &path, sockaddr_un &addr)
+    {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        const std::string &str = path.native();
+        if (str.size() >= sizeof(addr.sun_path))
+        {
+            return false;
+        }
+        std::memcpy(addr.sun_path, str.c_str(), str.size());
+        return true;
+    }
+};
+
+class CompletionClient
+{
+    // Sends a single completion request to the running CompletionServer
+  public:
+    CompletionClient(std::filesystem::path socket_path, int timeout_ms = 500)
+        : socket_path_{std::move(socket_path)}, timeout_ms_{timeout_ms}
+    {
+    }
+
+    // Returns nullopt if there is no server, the server is stale or failed to
+    // answer in time. In this case the caller should complete the line itself.
+    std::optional<std::vector<std::string>> complete(std::optional<uint64_t> schema_hash, std::string_view line,
+                                                     std::optional<size_t> point = std::nullopt) const
+    {
+        int fd = CompletionProtocol::connectTo(socket_path_);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+        std::string response;
+        bool ok = CompletionProtocol::writeAll(fd, CompletionProtocol::formatRequest(schema_hash, line, point)) &&
+                  shutdown(fd, SHUT_WR) == 0 &&
+                  CompletionProtocol::readAll(fd, response, timeout_ms_, std::numeric_limits<size_t>::max());
+        close(fd);
+        if (!ok || !response.starts_with("OK\n"))
+        {
+            return std::nullopt;
+        }
+        std::vector<std::string> res;
+        std::string_view rest = std::string_view(response).substr(3);
+        while (!rest.empty())
+        {
+            auto eol = rest.find('\n');
+            res.emplace_back(rest.substr(0, eol));
+            rest.remove_prefix(eol == std::string_view::npos ? rest.size() : eol + 1);
+        }
+        return res;
+    }
+
+  private:
+    std::filesystem::path socket_path_;
+    int timeout_ms_;
+};
+
+class CompletionServer
+{
+    // Keeps the completion index in memory and answers the requests sent over
+    // the per-user Unix domain socket, exits after idle_timeout without
+    // requests or as soon as a client with another schema hash connects.
+  public:
+    using handler_t = std::function<std::vector<std::string>(const std::string &line)>;
+
+    CompletionServer(std::filesystem::path socket_path, uint64_t schema_hash, handler_t handler,
+                     std::chrono::milliseconds idle_timeout = std::chrono::minutes(10))
+        : socket_path_{std::move(socket_path)}, schema_hash_{schema_hash}, handler_{std::move(handler)},
+          idle_timeout_{idle_timeout}
+    {
+        std::error_code ec;
+        exe_path_ = std::filesystem::read_symlink("/proc/self/exe", ec);
+        exe_identity_ = ExecutableIdentity::current();
+    }
+    ~CompletionServer()
+    {
+        stop();
+    }
+
+    // Binds the socket. If another server is listening on the same path it is
+    // asked to quit when its schema differs, otherwise false is returned.
+    // The directory of the socket must be private, see
+    // CompletionProtocol::preparePrivateDirectory.
+    bool listen()
+    {
+        if (!CompletionProtocol::preparePrivateDirectory(socket_path_.parent_path()))
+        {
+            return false;
+        }
+        if (int fd = CompletionProtocol::connectTo(socket_path_); fd >= 0)
+        {
+            std::string response;
+            bool alive = CompletionProtocol::writeAll(fd, CompletionProtocol::formatRequest(schema_hash_, "", {})) &&
+                         shutdown(fd, SHUT_WR) == 0 && CompletionProtocol::readAll(fd, response, 1000);
+            close(fd);
+            if (alive && response.starts_with("OK\n"))
+            {
+                return false; // an up-to-date server is running already
+            }
+        }
+        unlink(socket_path_.c_str());
+
+        sockaddr_un addr;
+        if (!CompletionProtocol::makeAddress(socket_path_, addr))
+        {
+            return false;
+        }
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0)
+        {
+            return false;
+        }
+        mode_t old_mask = umask(0077); // the socket is accessible for the owner only
+        int rc = bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+        umask(old_mask);
+        if (rc != 0 || ::listen(listen_fd_, 16) != 0)
+        {
+            close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+        struct stat st;
+        if (stat(socket_path_.c_str(), &st) == 0)
+        {
+            socket_inode_ = st.st_ino;
+        }
+        return true;
+    }
+
+    // Serves the requests until idle timeout or stale schema
+    void run()
+    {
+        while (listen_fd_ >= 0)
+        {
+            pollfd pfd{listen_fd_, POLLIN, 0};
+            int ready = poll(&pfd, 1, static_cast<int>(idle_timeout_.count()));
+            if (ready < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (ready <= 0)
+            {
+                break; // idle timeout
+            }
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                continue;
+            }
+            if (!CompletionProtocol::isPeerTrusted(fd))
+            {
+                close(fd);
+                continue;
+            }
+            bool keep_running = serve(fd);
+            close(fd);
+            if (!keep_running)
+            {
+                break;
+            }
+        }
+        stop();
+    }
+
+    void stop()
+    {
+        if (listen_fd_ < 0)
+        {
+            return;
+        }
+        close(listen_fd_);
+        listen_fd_ = -1;
+        // remove the socket only if it was not replaced by a newer server
+        struct stat st;
+        if (stat(socket_path_.c_str(), &st) == 0 && st.st_ino == socket_inode_)
+        {
+            unlink(socket_path_.c_str());
+        }
+    }
+
+  private:
+    std::filesystem::path socket_path_;
+    uint64_t schema_hash_;
+    handler_t handler_;
+    std::chrono::milliseconds idle_timeout_;
+    std::filesystem::path exe_path_;
+    std::optional<ExecutableIdentity> exe_identity_;
+    int listen_fd_{-1};
+    ino_t socket_inode_{0};
+
+    bool isStale(const CompletionProtocol::Request &request) const
+    {
+        if (request.schema_hash.has_value())
+        {
+            return request.schema_hash.value() != schema_hash_;
+        }
+        // the bash client can't check the schema, check that the executable
+        // was not rebuilt instead
+        struct stat st;
+        if (!exe_identity_.has_value() || stat(exe_path_.c_str(), &st) != 0)
+        {
+            return true;
+        }
+        int64_t mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        return static_cast<uint64_t>(st.st_size) != exe_identity_->size || mtime_ns != exe_identity_->mtime_ns;
+    }
+
+    // returns false if the server should quit
+    bool serve(int fd)
+    {
+        std::string data;
+        if (!CompletionProtocol::readAll(fd, data, 1000))
+        {
+            return true;
+        }
+        auto request = CompletionProtocol::parseRequest(data);
+        if (!request.has_value())
+        {
+            return true;
+        }
+        if (isStale(request.value()))
+        {
+            CompletionProtocol::writeAll(fd, "STALE\n");
+            return false;
+        }
+        std::string response = "OK\n";
+        for (const auto &it : handler_(request->line))
+        {
+            response += it;
+            response += "\n";
+        }
+        CompletionProtocol::writeAll(fd, response);
+        return true;
+    }
+};
+
+} /* namespace completion */
+
+} /* namespace program_options_heavy */
+
+#endif // __COMPLETION_SERVER_H__
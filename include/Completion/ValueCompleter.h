@@ -0,0 +1,141 @@
+#ifndef __VALUE_COMPLETER_H__
+#define __VALUE_COMPLETER_H__
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+namespace completion
+{
+
+class ValueCompleter
+{
+    // Generates the completions of the value of an option. The candidates are
+    // passed to emit() one by one as soon as they are found; emit() returns
+    // false when the caller has enough of them, then the generation stops.
+  public:
+    using emit_t = std::function<bool(std::string_view candidate)>;
+
+    virtual ~ValueCompleter() = default;
+    virtual void complete(std::string_view prefix, const emit_t &emit) const = 0;
+
+    // At most max_count candidates
+    std::vector<std::string> candidates(std::string_view prefix, size_t max_count) const
+    {
+        std::vector<std::string> res;
+        if (max_count == 0)
+        {
+            return res;
+        }
+        complete(prefix, [&res, max_count](std::string_view candidate) {
+            res.emplace_back(candidate);
+            return res.size() < max_count;
+        });
+        return res;
+    }
+};
+
+class EnumValues : public ValueCompleter
+{
+  public:
+    EnumValues(std::vector<std::string> values) : values_{std::move(values)}
+    {
+    }
+    void complete(std::string_view prefix, const emit_t &emit) const override
+    {
+        for (const auto &it : values_)
+        {
+            if (it.starts_with(prefix) && !emit(it))
+            {
+                return;
+            }
+        }
+    }
+
+  private:
+    std::vector<std::string> values_;
+};
+
+class PathValues : public ValueCompleter
+{
+    // The files in the directory of the prefix. The directory is read
+    // incrementally and filtered while reading, the scan stops when the
+    // caller has enough candidates or after max_scanned entries, so huge
+    // directories give a truncated result quickly. The directories are
+    // completed with the trailing '/'.
+  public:
+    PathValues(bool directories_only = false, size_t max_scanned = 100000)
+        : directories_only_{directories_only}, max_scanned_{max_scanned}
+    {
+    }
+    void complete(std::string_view prefix, const emit_t &emit) const override
+    {
+        size_t slash = prefix.rfind('/');
+        std::string_view dir = slash == std::string_view::npos ? std::string_view() : prefix.substr(0, slash + 1);
+        std::string_view base = prefix.substr(dir.size());
+        std::error_code ec;
+        std::filesystem::directory_iterator it(dir.empty() ? std::filesystem::path(".") : std::filesystem::path(dir),
+                                               std::filesystem::directory_options::skip_permission_denied, ec);
+        std::string candidate(dir);
+        for (size_t scanned = 0; !ec && it != std::filesystem::directory_iterator() && scanned < max_scanned_;
+             it.increment(ec), scanned++)
+        {
+            std::string name = it->path().filename().native();
+            if (!name.starts_with(base) || (base.empty() && name.starts_with('.')))
+            {
+                continue; // hidden files are completed only if asked explicitly
+            }
+            // the entries which status fails (dangling symlinks) are files,
+            // the error must not end the scan
+            std::error_code status_ec;
+            bool is_directory = it->is_directory(status_ec);
+            if (directories_only_ && !is_directory)
+            {
+                continue;
+            }
+            candidate.resize(dir.size());
+            candidate += name;
+            if (is_directory)
+            {
+                candidate += '/';
+            }
+            if (!emit(candidate))
+            {
+                return;
+            }
+        }
+    }
+
+  private:
+    bool directories_only_;
+    size_t max_scanned_;
+};
+
+class CallbackValues : public ValueCompleter
+{
+  public:
+    using callback_t = std::function<void(std::string_view prefix, const emit_t &emit)>;
+
+    CallbackValues(callback_t callback) : callback_{std::move(callback)}
+    {
+    }
+    void complete(std::string_view prefix, const emit_t &emit) const override
+    {
+        callback_(prefix, emit);
+    }
+
+  private:
+    callback_t callback_;
+};
+
+} /* namespace completion */
+
+} /* namespace program_options_heavy */
+
+#endif // __VALUE_COMPLETER_H__
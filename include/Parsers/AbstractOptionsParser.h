@@ -1,8 +1,11 @@
 #ifndef __ABSTRACT_OPTIONS_PARSER_H__
 #define __ABSTRACT_OPTIONS_PARSER_H__
 
-#include <boost/program_options.hpp>
+#include <Parsers/ParseStats.h>
+
+#include <boost/program_options/variables_map.hpp>
 #include <filesystem>
+#include <memory>
 
 namespace program_options_heavy
 {
@@ -26,8 +29,22 @@ class AbstractOptionsParser
     virtual void validate() = 0;
     virtual void update(const boost::program_options::variables_map &vm) = 0;
 
+    // The phases of the following parses are recorded into stats, nullptr
+    // disables the recording
+    void setParseStats(std::shared_ptr<ParseStats> stats)
+    {
+        parse_stats_ = std::move(stats);
+    }
+    const std::shared_ptr<ParseStats> &parseStats() const
+    {
+        return parse_stats_;
+    }
+
     std::string exename;
     std::string program_description;
+
+  protected:
+    std::shared_ptr<ParseStats> parse_stats_;
 };
 
 } /* namespace program_options_heavy */
@@ -0,0 +1,436 @@
+#ifndef __BATCH_RUNNER_H__
+#define __BATCH_RUNNER_H__
+
+#include <Parsers/BasicOptions.h>
+#include <Parsers/ParserWithSubcommands.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+// Splits the line into arguments the way a shell does: arguments are
+// separated by whitespace, '...' is taken literally, "..." and the rest of
+// the line may contain backslash escapes.
+inline std::vector<std::string> tokenizeCommandLine(std::string_view line)
+{
+    std::vector<std::string> res;
+    std::string current;
+    bool in_token = false;
+    char quote = '\0';
+    for (size_t n = 0; n < line.size(); n++)
+    {
+        char ch = line[n];
+        if (quote == '\'')
+        {
+            if (ch == '\'')
+            {
+                quote = '\0';
+            }
+            else
+            {
+                current += ch;
+            }
+            continue;
+        }
+        if (ch == '\\' && n + 1 < line.size())
+        {
+            current += line[++n];
+            in_token = true;
+            continue;
+        }
+        if (quote == '"')
+        {
+            if (ch == '"')
+            {
+                quote = '\0';
+            }
+            else
+            {
+                current += ch;
+            }
+            continue;
+        }
+        if (ch == '\'' || ch == '"')
+        {
+            quote = ch;
+            in_token = true;
+        }
+        else if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
+        {
+            if (in_token)
+            {
+                res.push_back(std::move(current));
+                current.clear();
+                in_token = false;
+            }
+        }
+        else
+        {
+            current += ch;
+            in_token = true;
+        }
+    }
+    if (quote != '\0')
+    {
+        throw std::runtime_error("Unterminated quote in the command line");
+    }
+    if (in_token)
+    {
+        res.push_back(std::move(current));
+    }
+    return res;
+}
+
+class BatchRunner
+{
+    // Runs a manifest with one command line per line against the
+    // ParserWithSubcommands. Every worker builds its parser with the factory
+    // once and parses its lines with it, then the handler registered for the
+    // selected subcommand is called. The nested subcommands are registered by
+    // their paths, e.g. "cluster node drain" (see
+    // ParserWithSubcommands::selectedPath). The handler can reach the parsed
+    // values through parser.selectedSubcommand()->groups().
+    //
+    // The values are bound to the options of the parser, so after the handler
+    // the variables of the options without default values set by the line are
+    // reset to T{} (the notifiers are called with T{} too), the next line does
+    // not see them. If the type of such an option is not known here (see
+    // resetter) or a notifier rejects T{}, the parser is built again for the
+    // next line, as it is after a failed line.
+    //
+    // Empty lines and the lines starting with '#' are skipped. An error in a
+    // line (tokenizing, parsing or the handler throws) is recorded in the
+    // report and does not stop the batch.
+  public:
+    using factory_t = std::function<std::shared_ptr<ParserWithSubcommands>()>;
+    using handler_t = std::function<void(ParserWithSubcommands &parser)>;
+
+    enum class Completion
+    {
+        Ordered,  // results are reported in the order of the manifest
+        Unordered // results are reported as soon as the lines are processed
+    };
+    struct LineResult
+    {
+        size_t line_number{0}; // starting from 1
+        std::string line{};
+        bool ok{true};
+        std::string error{};
+    };
+    struct Report
+    {
+        size_t processed{0};
+        size_t failed{0};
+        std::vector<LineResult> errors; // in the order of reporting
+    };
+
+    BatchRunner(factory_t factory, size_t nthreads) : factory_{std::move(factory)}, nthreads_{std::max<size_t>(nthreads, 1)}
+    {
+    }
+    BatchRunner(factory_t factory, MultithreadOptions &options) : BatchRunner(std::move(factory), options.nThreads())
+    {
+    }
+
+    void addHandler(const std::string &subcommand_name, handler_t handler)
+    {
+        handlers_[subcommand_name] = std::move(handler);
+    }
+    void setCompletion(Completion completion)
+    {
+        completion_ = completion;
+    }
+    // Called for every processed line, from one thread at a time
+    void setResultCallback(std::function<void(const LineResult &)> callback)
+    {
+        result_callback_ = std::move(callback);
+    }
+    // Maximal number of lines read ahead of the processing
+    void setQueueSize(size_t queue_size)
+    {
+        queue_size_ = std::max<size_t>(queue_size, 1);
+    }
+
+    Report run(std::istream &manifest)
+    {
+        State state;
+        std::vector<std::thread> workers;
+        for (size_t n = 0; n < nthreads_; n++)
+        {
+            workers.emplace_back([this, &state]() { work(state); });
+        }
+
+        std::string line;
+        size_t line_number = 0;
+        size_t sequence = 0; // of the processed lines, the skipped lines are not counted
+        while (std::getline(manifest, line))
+        {
+            line_number++;
+            auto first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#')
+            {
+                continue;
+            }
+            std::unique_lock lock(state.mutex);
+            // in the ordered mode a slow line holds the results of the
+            // following lines, the window keeps this buffer bounded too
+            state.can_push.wait(lock, [this, &state, sequence]() {
+                return state.failure || (state.queue.size() < queue_size_ &&
+                                         (completion_ == Completion::Unordered ||
+                                          sequence - state.next_to_report < queue_size_ + nthreads_));
+            });
+            if (state.failure)
+            {
+                break;
+            }
+            state.queue.push_back({sequence++, line_number, std::move(line)});
+            state.can_pop.notify_one();
+        }
+        {
+            std::lock_guard lock(state.mutex);
+            state.finished = true;
+        }
+        state.can_pop.notify_all();
+        for (auto &it : workers)
+        {
+            it.join();
+        }
+        if (state.failure)
+        {
+            std::rethrow_exception(state.failure);
+        }
+        return std::move(state.report);
+    }
+
+  private:
+    factory_t factory_;
+    size_t nthreads_;
+    size_t queue_size_{1024};
+    Completion completion_{Completion::Unordered};
+    std::map<std::string, handler_t> handlers_;
+    std::function<void(const LineResult &)> result_callback_;
+
+    struct Job
+    {
+        size_t sequence{0};
+        size_t line_number{0};
+        std::string line{};
+    };
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable can_push;
+        std::condition_variable can_pop;
+        std::deque<Job> queue;
+        bool finished{false};
+        std::exception_ptr failure; // the factory failed, the batch is stopped
+
+        // ordered completion
+        size_t next_to_report{0};
+        std::map<size_t, LineResult> pending; // by sequence numbers
+
+        Report report;
+    };
+
+    using reset_t = std::function<void()>;
+
+    void work(State &state)
+    {
+        std::shared_ptr<ParserWithSubcommands> parser;
+        while (true)
+        {
+            Job item;
+            {
+                std::unique_lock lock(state.mutex);
+                state.can_pop.wait(lock, [&state]() { return !state.queue.empty() || state.finished; });
+                if (state.queue.empty())
+                {
+                    return;
+                }
+                item = std::move(state.queue.front());
+                state.queue.pop_front();
+                state.can_push.notify_one();
+            }
+            if (!parser && !(parser = build(state)))
+            {
+                return;
+            }
+            LineResult result{item.line_number, std::move(item.line)};
+            if (!process(*parser, result))
+            {
+                parser.reset();
+            }
+            finish(state, item.sequence, std::move(result));
+        }
+    }
+
+    // Returns nullptr and stops the batch if the factory fails
+    std::shared_ptr<ParserWithSubcommands> build(State &state)
+    {
+        try
+        {
+            return factory_();
+        }
+        catch (...)
+        {
+            std::lock_guard lock(state.mutex);
+            if (!state.failure)
+            {
+                state.failure = std::current_exception();
+            }
+            state.finished = true;
+            state.queue.clear();
+            state.can_push.notify_all();
+            state.can_pop.notify_all();
+            return nullptr;
+        }
+    }
+
+    // Returns false if the parser can't be used for the next line
+    bool process(ParserWithSubcommands &parser, LineResult &result)
+    {
+        std::shared_ptr<Parser> selected;
+        try
+        {
+            std::vector<std::string> args = tokenizeCommandLine(result.line);
+            std::vector<const char *> argv{parser.exename.c_str()};
+            for (const auto &it : args)
+            {
+                argv.push_back(it.c_str());
+            }
+            parser.parse(static_cast<int>(argv.size()), argv.data());
+            selected = parser.selectedSubcommand();
+            std::string path = parser.selectedPath();
+            auto handler = handlers_.find(path);
+            if (handler == handlers_.end())
+            {
+                throw std::runtime_error("No handler is registered for the subcommand " + path);
+            }
+            handler->second(parser);
+        }
+        catch (const std::exception &e)
+        {
+            result.ok = false;
+            result.error = e.what();
+        }
+        catch (...)
+        {
+            result.ok = false;
+            result.error = "Unknown error";
+        }
+        // the failed parse may have assigned a part of the variables
+        return selected && resetWithoutDefaults(*selected);
+    }
+
+    // Resets the variables of the options without default values given by
+    // the last line, returns false if some of them can't be reset
+    static bool resetWithoutDefaults(const Parser &parser)
+    {
+        const auto &values = parser.values();
+        for (const auto &group : parser.groups())
+        {
+            for (const auto &opt : group->partial.options())
+            {
+                auto it = values.find(opt->key(std::string()));
+                boost::any unused;
+                if (it == values.end() || it->second.defaulted() || opt->semantic()->apply_default(unused))
+                {
+                    continue;
+                }
+                reset_t reset = resetter(*opt->semantic());
+                if (!reset)
+                {
+                    return false;
+                }
+                try
+                {
+                    reset();
+                }
+                catch (...)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Assigns T{} to the variable of the po::value<T> or typedValue<T> of
+    // the common types, nullptr for the other types
+    static reset_t resetter(const boost::program_options::value_semantic &semantic)
+    {
+        auto typed = dynamic_cast<const boost::program_options::typed_value_base *>(&semantic);
+        if (!typed)
+        {
+            return nullptr;
+        }
+        return resetter<std::string, bool, int, unsigned, long, unsigned long, long long, unsigned long long, float,
+                        double, std::vector<std::string>>(semantic, typed->value_type());
+    }
+    template <class T, class... Rest>
+    static reset_t resetter(const boost::program_options::value_semantic &semantic, const std::type_info &type)
+    {
+        if (type == typeid(T))
+        {
+            return [&semantic]() { semantic.notify(boost::any(T{})); };
+        }
+        if constexpr (sizeof...(Rest) > 0)
+        {
+            return resetter<Rest...>(semantic, type);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    void finish(State &state, size_t sequence, LineResult result)
+    {
+        std::lock_guard lock(state.mutex);
+        if (completion_ == Completion::Unordered)
+        {
+            report(state, result);
+            return;
+        }
+        state.pending.emplace(sequence, std::move(result));
+        for (auto it = state.pending.begin(); it != state.pending.end() && it->first == state.next_to_report;
+             it = state.pending.erase(it))
+        {
+            report(state, it->second);
+            state.next_to_report++;
+        }
+        state.can_push.notify_all();
+    }
+
+    void report(State &state, const LineResult &result)
+    {
+        state.report.processed++;
+        if (!result.ok)
+        {
+            state.report.failed++;
+            state.report.errors.push_back(result);
+        }
+        if (result_callback_)
+        {
+            result_callback_(result);
+        }
+    }
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __BATCH_RUNNER_H__
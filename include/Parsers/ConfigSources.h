@@ -0,0 +1,190 @@
+#ifndef __CONFIG_SOURCES_H__
+#define __CONFIG_SOURCES_H__
+
+#include <Parsers/MappedFile.h>
+
+#include <boost/program_options/errors.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+extern char **environ;
+
+namespace program_options_heavy
+{
+
+struct ConfigSources
+{
+    // Sources of the option values besides the command line. The command line
+    // takes precedence over the environment, the environment takes precedence
+    // over the config file, the config file takes precedence over the
+    // defaults.
+    std::optional<std::filesystem::path> config_file;
+    bool config_file_required{false}; // if false, the missing config file is ignored
+    // MY_TOOL_BUFFER_SIZE sets the option buffer-size, or buffer_size if
+    // there is no buffer-size; the names mixing '-' and '_' are not reachable
+    bool use_environment{false};
+    std::string environment_prefix; // derived from the exename if empty, see environmentPrefix()
+
+    // "my-tool" -> "MY_TOOL_"
+    static std::string environmentPrefix(std::string_view exename)
+    {
+        exename = exename.substr(exename.find_last_of('/') + 1);
+        std::string res;
+        for (char ch : exename)
+        {
+            res += std::isalnum(static_cast<unsigned char>(ch)) ? std::toupper(static_cast<unsigned char>(ch)) : '_';
+        }
+        return res + "_";
+    }
+};
+
+class ConfigFile
+{
+    // The config file in the format of boost::program_options::parse_config_file:
+    //
+    //   # comment
+    //   name = value
+    //   [section]
+    //   name = value   # the option section.name
+    //
+    // The file is mapped into memory and the names and the values are passed
+    // to the visitor as views of the mapped file, so nothing is copied except
+    // the names inside sections.
+  public:
+    using visitor_t = std::function<void(std::string_view name, std::string_view value)>;
+
+    ConfigFile(const std::filesystem::path &path) : path_{path}, file_{path}
+    {
+    }
+
+    void visit(const visitor_t &visitor) const
+    {
+        std::string_view text = file_.data();
+        std::string section;
+        std::string name; // reused for the names inside sections
+        size_t line_number = 0;
+        for (size_t pos = 0; pos < text.size();)
+        {
+            size_t end = std::min(text.find('\n', pos), text.size());
+            std::string_view line = text.substr(pos, end - pos);
+            pos = end + 1;
+            line_number++;
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty())
+            {
+                continue;
+            }
+            if (line.front() == '[' && line.back() == ']')
+            {
+                section = std::string(trim(line.substr(1, line.size() - 2)));
+                if (!section.empty())
+                {
+                    section += '.';
+                }
+                continue;
+            }
+            size_t eq = line.find('=');
+            std::string_view key = trim(line.substr(0, eq));
+            if (eq == std::string_view::npos || key.empty())
+            {
+                throw boost::program_options::invalid_config_file_syntax(
+                    path_.string() + ":" + std::to_string(line_number) + ": " + std::string(line),
+                    boost::program_options::invalid_syntax::unrecognized_line);
+            }
+            if (!section.empty())
+            {
+                name.assign(section).append(key);
+                key = name;
+            }
+            visitor(key, trim(line.substr(eq + 1)));
+        }
+    }
+
+  private:
+    std::filesystem::path path_;
+    MappedFile file_;
+
+    static std::string_view trim(std::string_view str)
+    {
+        size_t first = str.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos)
+        {
+            return {};
+        }
+        return str.substr(first, str.find_last_not_of(" \t\r") - first + 1);
+    }
+};
+
+class Environment
+{
+    // The environment variables with the given prefix, keyed by the option
+    // names: MY_TOOL_BUFFER_SIZE -> buffer-size, MY_TOOL_NET__PORT -> net.port.
+    // environ is scanned once when the object is created, the values are
+    // copied, so the later changes of the environment are not seen.
+  public:
+    Environment(std::string_view prefix) : prefix_{prefix}
+    {
+        for (char **it = environ; it && *it; it++)
+        {
+            std::string_view var = *it;
+            size_t eq = var.find('=');
+            if (eq == std::string_view::npos || eq <= prefix.size() || !var.starts_with(prefix))
+            {
+                continue;
+            }
+            variables_.emplace(optionName(var.substr(prefix.size(), eq - prefix.size())), var.substr(eq + 1));
+        }
+    }
+    const std::unordered_map<std::string, std::string> &variables() const
+    {
+        return variables_;
+    }
+    const std::string &prefix() const
+    {
+        return prefix_;
+    }
+    // The name of variables() with '_' kept: buffer-size -> buffer_size
+    static std::string underscoreName(std::string_view name)
+    {
+        std::string res(name);
+        std::replace(res.begin(), res.end(), '-', '_');
+        return res;
+    }
+
+  private:
+    std::string prefix_;
+    std::unordered_map<std::string, std::string> variables_;
+
+    static std::string optionName(std::string_view var)
+    {
+        std::string res;
+        for (size_t n = 0; n < var.size(); n++)
+        {
+            if (var[n] == '_' && n + 1 < var.size() && var[n + 1] == '_')
+            {
+                res += '.';
+                n++;
+            }
+            else if (var[n] == '_')
+            {
+                res += '-';
+            }
+            else
+            {
+                res += std::tolower(static_cast<unsigned char>(var[n]));
+            }
+        }
+        return res;
+    }
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __CONFIG_SOURCES_H__
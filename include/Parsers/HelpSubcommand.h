@@ -4,6 +4,9 @@
 #include <Parsers/BasicOptions.h>
 #include <Parsers/Parser.h>
 
+#include <string>
+#include <vector>
+
 namespace program_options_heavy
 {
 
@@ -12,13 +15,38 @@ class HelpSubcommand : public Parser
   public:
     HelpSubcommand() : Parser()
     {
+        namespace po = boost::program_options;
         help_options = std::make_shared<program_options_heavy::HelpOptions>();
         addGroup(help_options);
+        auto topic = std::make_shared<OptionsGroup>("help topic");
+        topic->addPositionalVisible("subcommand", -1, po::value<std::vector<std::string>>(&topic_path_),
+                                    "show the help for this subcommand only, nested ones are given by the path");
+        addGroup(topic);
         program_description = "--help - produce this help";
     }
+    bool parse(int argc, const char *argv[]) override
+    {
+        topic_.clear();
+        topic_path_.clear();
+        bool res = Parser::parse(argc, argv);
+        for (const auto &it : topic_path_)
+        {
+            topic_ += (topic_.empty() ? "" : " ") + it;
+        }
+        return res;
+    }
+    // The subcommand of "prog help subcommand", empty if not specified. The
+    // path of a nested subcommand ("prog help cluster node drain") is joined
+    // by spaces, as ProgramSubcommandsPrinter::print expects it
+    const std::string &topic() const
+    {
+        return topic_;
+    }
     std::shared_ptr<program_options_heavy::HelpOptions> help_options;
 
   private:
+    std::string topic_;
+    std::vector<std::string> topic_path_;
 };
 
 } /* namespace program_options_heavy */
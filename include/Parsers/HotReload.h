@@ -0,0 +1,315 @@
+#ifndef __HOT_RELOAD_H__
+#define __HOT_RELOAD_H__
+
+#include <Parsers/ConfigSources.h>
+#include <Parsers/Parser.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace program_options_heavy
+{
+
+template <class Snapshot> class HotReload
+{
+    // Re-parses the options when the config file changes and publishes them
+    // as an immutable Snapshot built by make_snapshot from the destinations of
+    // the options. Worker threads read the snapshot on the hot path with
+    // snapshot(), or take it with current() and keep it as long as they
+    // need; the old snapshots are freed when the last reader releases them.
+    // The destinations themselves are rewritten by the reloading thread, so
+    // only make_snapshot may read them after start().
+    //
+    // A reload goes through the same Parser: the command line given to the
+    // constructor is parsed again together with the environment and the
+    // config file, then validate() is called. If anything throws the previous
+    // snapshot stays current, the destinations are restored from the values
+    // of the last valid parse (see Parser::values) and the error callback is
+    // called. The options without default values set only by the rejected
+    // config file can't be restored this way.
+  public:
+    using snapshot_factory_t = std::function<Snapshot()>;
+
+    // sources.config_file is required
+    HotReload(std::shared_ptr<Parser> parser, int argc, const char *argv[], const ConfigSources &sources,
+              snapshot_factory_t make_snapshot)
+        : parser_{std::move(parser)}, args_(argv, argv + argc), config_file_{configFile(sources)},
+          make_snapshot_{std::move(make_snapshot)}
+    {
+        parser_->setConfigSources(sources);
+        reparse();
+        valid_values_ = parser_->values();
+        groups_state_ = groupsState();
+        publish(std::make_shared<const Snapshot>(make_snapshot_()));
+    }
+    HotReload(const HotReload &) = delete;
+    HotReload &operator=(const HotReload &) = delete;
+    ~HotReload()
+    {
+        stop();
+    }
+
+    // Loading the atomic shared_ptr takes a lock and increments the shared
+    // reference count, use snapshot() for the frequent reads
+    std::shared_ptr<const Snapshot> current() const noexcept
+    {
+        return current_.load(std::memory_order_acquire);
+    }
+    // The current snapshot kept by the calling thread, valid until the next
+    // snapshot() in this thread. Costs one atomic load unless a snapshot was
+    // published since the previous call; the kept snapshot is released by
+    // the next call which sees the new one. A thread switching between
+    // HotReload objects of the same Snapshot takes the slow path every time.
+    const Snapshot &snapshot() const
+    {
+        thread_local Cache cache;
+        uint64_t version = version_.load(std::memory_order_acquire);
+        if (cache.version != version)
+        {
+            cache.snapshot = current();
+            cache.version = version;
+        }
+        return *cache.snapshot;
+    }
+
+    // Called in the reloading thread after the new snapshot is published for
+    // every group which values in the config file have changed
+    void onGroupChanged(std::function<void(OptionsGroup &)> callback)
+    {
+        on_group_changed_ = std::move(callback);
+    }
+    void onError(std::function<void(const std::exception &)> callback)
+    {
+        on_error_ = std::move(callback);
+    }
+
+    // Re-parses the options now, returns false if the new options are invalid
+    bool reload()
+    {
+        std::lock_guard lock(reload_mutex_);
+        std::vector<std::map<std::string, std::string>> state;
+        std::shared_ptr<const Snapshot> snapshot;
+        try
+        {
+            reparse();
+            state = groupsState();
+            snapshot = std::make_shared<const Snapshot>(make_snapshot_());
+        }
+        catch (const std::exception &e)
+        {
+            restore();
+            reportError(e);
+            return false;
+        }
+        valid_values_ = parser_->values();
+        publish(std::move(snapshot));
+        try
+        {
+            for (size_t n = 0; n < state.size(); n++)
+            {
+                if (state[n] != groups_state_[n] && on_group_changed_)
+                {
+                    on_group_changed_(*parser_->groups()[n]);
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            reportError(e);
+        }
+        groups_state_ = std::move(state);
+        return true;
+    }
+
+    // Starts watching the config file with inotify in the background thread
+    void start()
+    {
+        if (watcher_.joinable())
+        {
+            return;
+        }
+        inotify_fd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        stop_fd_ = eventfd(0, EFD_CLOEXEC);
+        if (inotify_fd_ < 0 || stop_fd_ < 0)
+        {
+            int err = errno;
+            closeDescriptors();
+            throw std::runtime_error(std::string("Cannot watch the config file: ") + std::strerror(err));
+        }
+        // the directory is watched since editors replace the file by rename
+        auto dir = config_file_.parent_path().empty() ? std::filesystem::path(".") : config_file_.parent_path();
+        if (inotify_add_watch(inotify_fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            int err = errno;
+            closeDescriptors();
+            throw std::runtime_error("Cannot watch " + dir.string() + ": " + std::strerror(err));
+        }
+        watcher_ = std::thread([this]() { watch(); });
+    }
+    void stop()
+    {
+        if (watcher_.joinable())
+        {
+            uint64_t one = 1;
+            [[maybe_unused]] auto res = write(stop_fd_, &one, sizeof(one));
+            watcher_.join();
+        }
+        closeDescriptors();
+    }
+
+  private:
+    std::shared_ptr<Parser> parser_;
+    std::vector<std::string> args_;
+    std::filesystem::path config_file_;
+    snapshot_factory_t make_snapshot_;
+    std::function<void(OptionsGroup &)> on_group_changed_;
+    std::function<void(const std::exception &)> on_error_;
+
+    std::atomic<std::shared_ptr<const Snapshot>> current_;
+    std::atomic<uint64_t> version_{0}; // of current_, unique among the HotReload<Snapshot> objects
+    static inline std::atomic<uint64_t> last_version_{0};
+    struct Cache
+    {
+        uint64_t version{0};
+        std::shared_ptr<const Snapshot> snapshot;
+    };
+    boost::program_options::variables_map valid_values_; // of the last valid parse
+    std::vector<std::map<std::string, std::string>> groups_state_; // config file values by groups
+    std::mutex reload_mutex_;
+
+    std::thread watcher_;
+    int inotify_fd_{-1};
+    int stop_fd_{-1};
+
+    void reparse()
+    {
+        std::vector<const char *> argv;
+        for (const auto &it : args_)
+        {
+            argv.push_back(it.c_str());
+        }
+        parser_->parse(static_cast<int>(argv.size()), argv.data());
+        parser_->validate();
+    }
+    void publish(std::shared_ptr<const Snapshot> snapshot)
+    {
+        // current_ first, so the reader seeing the version loads this
+        // snapshot or a newer one
+        current_.store(std::move(snapshot), std::memory_order_release);
+        version_.store(last_version_.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    // Rewrites the destinations with the values of the last valid parse
+    void restore()
+    {
+        boost::program_options::notify(valid_values_);
+        for (const auto &it : parser_->groups())
+        {
+            it->update(valid_values_);
+        }
+    }
+    void reportError(const std::exception &e)
+    {
+        if (on_error_)
+        {
+            on_error_(e);
+        }
+    }
+    static std::filesystem::path configFile(const ConfigSources &sources)
+    {
+        if (!sources.config_file.has_value())
+        {
+            throw std::runtime_error("HotReload needs the config file to watch");
+        }
+        return sources.config_file.value();
+    }
+    // The values of the config file grouped by the options groups, the
+    // command line and the environment don't change between reloads
+    std::vector<std::map<std::string, std::string>> groupsState() const
+    {
+        const auto &groups = parser_->groups();
+        std::vector<std::map<std::string, std::string>> res(groups.size());
+        if (!std::filesystem::exists(config_file_))
+        {
+            return res;
+        }
+        ConfigFile(config_file_).visit([&](std::string_view name, std::string_view value) {
+            for (size_t n = 0; n < groups.size(); n++)
+            {
+                if (groups[n]->partial.find_nothrow(std::string(name), false))
+                {
+                    res[n].emplace(name, value);
+                }
+            }
+        });
+        return res;
+    }
+    void watch()
+    {
+        std::string file_name = config_file_.filename();
+        alignas(inotify_event) char buffer[4096];
+        while (true)
+        {
+            pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+            if (poll(fds, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+            if (fds[1].revents)
+            {
+                return;
+            }
+            bool changed = false;
+            ssize_t len;
+            while ((len = read(inotify_fd_, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *pos = buffer; pos < buffer + len;)
+                {
+                    auto event = reinterpret_cast<const inotify_event *>(pos);
+                    if (event->len > 0 && file_name == event->name)
+                    {
+                        changed = true;
+                    }
+                    pos += sizeof(inotify_event) + event->len;
+                }
+            }
+            if (changed)
+            {
+                reload();
+            }
+        }
+    }
+    void closeDescriptors()
+    {
+        for (int *fd : {&inotify_fd_, &stop_fd_})
+        {
+            if (*fd >= 0)
+            {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __HOT_RELOAD_H__
@@ -0,0 +1,340 @@
+#ifndef __LIST_VALUE_H__
+#define __LIST_VALUE_H__
+
+#include <Parsers/TypedValue.h>
+
+#include <boost/any.hpp>
+#include <boost/program_options/value_semantic.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+namespace detail
+{
+
+// Parses the digits at p into value, 8 digits per step where the platform
+// allows it, and moves p past them. Returns false on overflow of uint64_t;
+// digits is the number of the digits parsed.
+bool parseDigits(const char *&p, const char *end, uint64_t &value, size_t &digits);
+
+// The token is shortened in the error messages, the lists may be huge
+std::string shortToken(std::string_view token);
+
+// One integer of the list at p, moves p past it
+template <class T> bool parseListInteger(const char *&p, const char *end, T &value, std::string &error)
+{
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    uint64_t magnitude = 0;
+    size_t digits = 0;
+    bool ok = parseDigits(p, end, magnitude, digits);
+    if (digits == 0)
+    {
+        error = std::is_signed_v<T> ? "expected an integer" : "expected a non-negative integer";
+        return false;
+    }
+    using limits = std::numeric_limits<T>;
+    if constexpr (std::is_signed_v<T>)
+    {
+        uint64_t max_magnitude = negative ? static_cast<uint64_t>(limits::max()) + 1 : limits::max();
+        if (!ok || magnitude > max_magnitude)
+        {
+            error = "out of range [" + formatNumber(limits::lowest()) + ", " + formatNumber(limits::max()) + "]";
+            return false;
+        }
+        value = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+    }
+    else
+    {
+        if (negative && magnitude != 0)
+        {
+            error = "expected a non-negative integer";
+            return false;
+        }
+        if (!ok || magnitude > limits::max())
+        {
+            error = "out of range [0, " + formatNumber(limits::max()) + "]";
+            return false;
+        }
+        value = static_cast<T>(magnitude);
+    }
+    return true;
+}
+
+} /* namespace detail */
+
+template <class T> class ListValue : public boost::program_options::value_semantic_codecvt_helper<char>,
+                                     public boost::program_options::typed_value_base
+{
+    // Value semantic of the long lists of numbers in one token:
+    // --ids 1,2,3,10-20 or --weights 0.5,0.25. The elements are split on the
+    // delimiter and written straight into the bound std::vector (cleared and
+    // reserved first) or span, without the vector of strings of multitoken
+    // options. The integers are parsed 8 digits at a time where the platform
+    // allows it, the floating point numbers with std::from_chars. The
+    // integer lists accept the inclusive ranges first-last.
+    //
+    // The elements are written during po::store, so a list rejected in the
+    // middle leaves the destination partially filled. The variables_map
+    // keeps std::span<const T> over the parsed elements.
+  public:
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "ListValue supports the numbers");
+
+    ListValue(std::vector<T> *vector, char delimiter) : vector_{vector}, delimiter_{delimiter}
+    {
+    }
+    ListValue(std::span<T> span, char delimiter) : span_{span}, delimiter_{delimiter}, max_size_{span.size()}
+    {
+    }
+
+    // More elements are rejected (64M by default), the span bounds it by its size
+    ListValue *max_size(size_t max_size)
+    {
+        max_size_ = vector_ ? max_size : std::min(max_size, span_.size());
+        return this;
+    }
+    ListValue *value_name(const std::string &name)
+    {
+        value_name_ = name;
+        return this;
+    }
+    ListValue *notifier(std::function<void(std::span<const T>)> callback)
+    {
+        notifier_ = std::move(callback);
+        return this;
+    }
+    ListValue *required()
+    {
+        required_ = true;
+        return this;
+    }
+
+    std::string name() const override
+    {
+        return value_name_.empty() ? boost::program_options::arg : value_name_;
+    }
+    unsigned min_tokens() const override
+    {
+        return 1;
+    }
+    unsigned max_tokens() const override
+    {
+        return 1;
+    }
+    bool is_composing() const override
+    {
+        return false;
+    }
+    bool is_required() const override
+    {
+        return required_;
+    }
+    bool apply_default(boost::any &value_store) const override
+    {
+        return false;
+    }
+    void notify(const boost::any &value_store) const override
+    {
+        if (notifier_)
+        {
+            notifier_(*boost::any_cast<std::span<const T>>(&value_store));
+        }
+    }
+    const std::type_info &value_type() const override
+    {
+        return typeid(std::span<const T>);
+    }
+
+    // Parses the list into the destination, returns the number of the
+    // elements or sets error to the reason
+    std::optional<size_t> parse(std::string_view token, std::string &error) const
+    {
+        size_t count = 0;
+        if (vector_)
+        {
+            vector_->clear();
+            size_t expected = static_cast<size_t>(std::count(token.begin(), token.end(), delimiter_)) + 1;
+            vector_->reserve(std::min(expected, max_size_));
+        }
+        auto put = [this, &count, &error](T value) {
+            if (count == max_size_)
+            {
+                error = "more than " + std::to_string(max_size_) + " values";
+                return false;
+            }
+            if (vector_)
+            {
+                vector_->push_back(value);
+            }
+            else
+            {
+                span_[count] = value;
+            }
+            count++;
+            return true;
+        };
+        const char *p = token.data();
+        const char *end = p + token.size();
+        while (p != end)
+        {
+            const char *element = p;
+            T first{};
+            if (!parseElement(p, end, first, error))
+            {
+                return fail(token, element, error);
+            }
+            T last = first;
+            if constexpr (std::is_integral_v<T>)
+            {
+                if (p != end && *p == '-')
+                {
+                    p++;
+                    if (!parseElement(p, end, last, error))
+                    {
+                        return fail(token, element, error);
+                    }
+                    if (last < first)
+                    {
+                        error = "empty range";
+                        return fail(token, element, error);
+                    }
+                    // the range is rejected before any of its values is
+                    // written, range_size is 0 for the whole range of uint64_t
+                    uint64_t range_size = static_cast<uint64_t>(last) - static_cast<uint64_t>(first) + 1;
+                    if (range_size == 0 || range_size > max_size_ - count)
+                    {
+                        error = "more than " + std::to_string(max_size_) + " values";
+                        return fail(token, element, error);
+                    }
+                    if (vector_ && count + range_size > vector_->capacity())
+                    {
+                        vector_->reserve(std::max<size_t>(count + range_size, vector_->capacity() * 2));
+                    }
+                }
+            }
+            for (T value = first;; value++)
+            {
+                if (!put(value))
+                {
+                    return fail(token, element, error);
+                }
+                if (value == last)
+                {
+                    break;
+                }
+            }
+            if (p != end)
+            {
+                if (*p != delimiter_)
+                {
+                    error = detail::unexpectedCharacter(token, p);
+                    return std::nullopt;
+                }
+                if (++p == end)
+                {
+                    error = "empty value at position " + std::to_string(p - token.data());
+                    return std::nullopt;
+                }
+            }
+        }
+        return count;
+    }
+
+  protected:
+    void xparse(boost::any &value_store, const std::vector<std::string> &new_tokens) const override
+    {
+        namespace po = boost::program_options;
+        po::validators::check_first_occurrence(value_store);
+        const std::string &token = po::validators::get_single_string(new_tokens, true);
+        std::string error;
+        auto count = parse(token, error);
+        if (!count.has_value())
+        {
+            throw InvalidValue(detail::shortToken(token), error);
+        }
+        const T *data = vector_ ? vector_->data() : span_.data();
+        value_store = std::span<const T>(data, count.value());
+    }
+
+  private:
+    std::vector<T> *vector_{nullptr};
+    std::span<T> span_;
+    char delimiter_;
+    size_t max_size_{size_t(1) << 26}; // a typo in a range should not take all the memory
+    std::string value_name_;
+    std::function<void(std::span<const T>)> notifier_;
+    bool required_{false};
+
+    bool parseElement(const char *&p, const char *end, T &value, std::string &error) const
+    {
+        if (p == end || *p == delimiter_)
+        {
+            error = "empty value";
+            return false;
+        }
+        if constexpr (std::is_integral_v<T>)
+        {
+            return detail::parseListInteger(p, end, value, error);
+        }
+        else
+        {
+            const char *element_end = std::find(p, end, delimiter_);
+            if (*p == '+' && p + 1 != element_end && p[1] != '-')
+            {
+                p++; // from_chars does not accept the plus sign
+            }
+            auto res = std::from_chars(p, element_end, value);
+            if (res.ec == std::errc::result_out_of_range)
+            {
+                error = "out of range";
+                return false;
+            }
+            if (res.ec != std::errc())
+            {
+                error = "expected a number";
+                return false;
+            }
+            p = res.ptr;
+            return true;
+        }
+    }
+    std::nullopt_t fail(std::string_view token, const char *element, std::string &error) const
+    {
+        error += " at position " + std::to_string(element - token.data());
+        return std::nullopt;
+    }
+};
+
+// Binds the list to the vector: listValue(&ids) parses --ids 1,2,10-20
+template <class T> ListValue<T> *listValue(std::vector<T> *store, char delimiter = ',')
+{
+    return new ListValue<T>(store, delimiter);
+}
+
+// Writes the list into the preallocated span, the number of the values is
+// given to the notifier and kept in the variables_map
+template <class T> ListValue<T> *listValue(std::span<T> store, char delimiter = ',')
+{
+    return new ListValue<T>(store, delimiter);
+}
+
+} /* namespace program_options_heavy */
+
+#endif // __LIST_VALUE_H__
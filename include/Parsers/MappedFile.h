@@ -0,0 +1,86 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace program_options_heavy
+{
+
+class MappedFile
+{
+    // Read-only private mapping of the whole file. The contents is available
+    // as a string_view while the object is alive, nothing is copied.
+  public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open " + path.string() + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            int err = errno;
+            close(fd);
+            throw std::runtime_error("Cannot stat " + path.string() + ": " + std::strerror(err));
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) // mmap refuses empty mappings
+        {
+            void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                int err = errno;
+                close(fd);
+                throw std::runtime_error("Cannot map " + path.string() + ": " + std::strerror(err));
+            }
+            data_ = static_cast<const char *>(addr);
+        }
+        close(fd);
+    }
+    MappedFile(MappedFile &&other) noexcept
+        : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)}
+    {
+    }
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile()
+    {
+        if (data_)
+        {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+
+    std::string_view data() const
+    {
+        return std::string_view(data_, size_);
+    }
+
+  private:
+    const char *data_{nullptr};
+    size_t size_{0};
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __MAPPED_FILE_H__
@@ -0,0 +1,105 @@
+#ifndef __NAME_INDEX_H__
+#define __NAME_INDEX_H__
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+class NameIndex
+{
+    // Open addressing hash table from names to the numbers of the items
+    // stored elsewhere (e.g. in a vector in the insertion order). The names
+    // are not copied: the caller checks the candidates with the predicate, so
+    // the lookup by string_view or const char* allocates nothing and usually
+    // costs one probe in a flat array.
+  public:
+    static constexpr uint32_t empty = static_cast<uint32_t>(-1);
+
+    // name_of(value) returns the name of the item with the given number
+    template <class NameOf> void insert(std::string_view name, uint32_t value, NameOf name_of)
+    {
+        if ((size_ + 1) * 2 > slots_.size())
+        {
+            rehash(std::max<size_t>(16, slots_.size() * 2), name_of);
+        }
+        place(hash(name), value);
+        size_++;
+    }
+
+    template <class NameOf> std::optional<uint32_t> find(std::string_view name, NameOf name_of) const
+    {
+        if (slots_.empty())
+        {
+            return std::nullopt;
+        }
+        size_t h = hash(name);
+        uint32_t tag = static_cast<uint32_t>(h);
+        for (size_t pos = h & mask();; pos = (pos + 1) & mask())
+        {
+            const Slot &slot = slots_[pos];
+            if (slot.value == empty)
+            {
+                return std::nullopt;
+            }
+            if (slot.tag == tag && name_of(slot.value) == name)
+            {
+                return slot.value;
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+  private:
+    struct Slot
+    {
+        uint32_t tag; // low bits of the hash, rejects most of the mismatches without comparing names
+        uint32_t value;
+    };
+    std::vector<Slot> slots_;
+    size_t size_{0};
+
+    static size_t hash(std::string_view name)
+    {
+        return std::hash<std::string_view>{}(name);
+    }
+    size_t mask() const
+    {
+        return slots_.size() - 1;
+    }
+    void place(size_t h, uint32_t value)
+    {
+        size_t pos = h & mask();
+        while (slots_[pos].value != empty)
+        {
+            pos = (pos + 1) & mask();
+        }
+        slots_[pos] = Slot{static_cast<uint32_t>(h), value};
+    }
+    template <class NameOf> void rehash(size_t slots_count, NameOf name_of)
+    {
+        std::vector<Slot> old = std::move(slots_);
+        slots_.assign(std::bit_ceil(slots_count), Slot{0, empty});
+        for (const auto &slot : old)
+        {
+            if (slot.value != empty)
+            {
+                place(hash(name_of(slot.value)), slot.value);
+            }
+        }
+    }
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __NAME_INDEX_H__
@@ -1,10 +1,20 @@
 #ifndef __OPTIONS_GROUP_H__
 #define __OPTIONS_GROUP_H__
 
+#include <Completion/ValueCompleter.h>
+#include <Parsers/OptionsSchema.h>
+#include <Parsers/PositionalSink.h>
+
 #include <boost/make_shared.hpp>
-#include <boost/program_options.hpp>
+#include <boost/program_options/errors.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/positional_options.hpp>
+#include <boost/program_options/value_semantic.hpp>
+#include <boost/program_options/variables_map.hpp>
 
 #include <cstdint>
+#include <map>
+#include <memory>
 
 namespace program_options_heavy
 {
@@ -31,6 +41,7 @@ class OptionsGroup
         auto option = boost::make_shared<boost::program_options::option_description>(args...);
         partial.add(option);
         visible.add(option);
+        schema_.reset();
         return option;
     }
     void addPositionalHidden(std::string name, int count, const boost::program_options::value_semantic *s)
@@ -50,9 +61,51 @@ class OptionsGroup
         positional.add(name.c_str(), count);
         partial.add(option);
         visible.add(option);
+        schema_.reset();
+        return option;
+    }
+
+    // The positional values are passed to the sink instead of the
+    // variables_map, see PositionalSink. If null_switch is true, also adds
+    // the switch --null,-0 for the values read from stdin.
+    auto addPositionalSink(std::string name, std::shared_ptr<PositionalSink> sink, std::string description,
+                           bool null_switch = false)
+    {
+        auto option = addPositionalVisible(name, -1, boost::program_options::value<std::vector<std::string>>(),
+                                           description);
+        if (null_switch)
+        {
+            addPartialVisible("null,0", boost::program_options::bool_switch(&sink->nul_delimited),
+                              "the values read from stdin are terminated by '\\0' instead of the newline");
+        }
+        positional_sink = std::move(sink);
         return option;
     }
 
+    // Values of the option are completed by Completer with this completer,
+    // name is the long name of the option. The completers are not stored in
+    // the completion cache: Completer::completeFromCache leaves the values to
+    // the full completer. The completion server runs them in its own process,
+    // so PathValues sees the working directory of the server, not the
+    // directory of the shell.
+    void setValueCompleter(const std::string &name, std::shared_ptr<completion::ValueCompleter> completer)
+    {
+        value_completers[name] = std::move(completer);
+        schema_.reset();
+    }
+
+    // The visible options with their names and completers, built once after
+    // the group is changed with the functions above (not after the direct
+    // changes of visible or value_completers)
+    const OptionsSchema &schema() const
+    {
+        if (!schema_)
+        {
+            schema_ = std::make_shared<const OptionsSchema>(visible, value_completers);
+        }
+        return *schema_;
+    }
+
     virtual void validate()
     {
         // nothing to do
@@ -67,6 +120,8 @@ class OptionsGroup
     // These vars are used only for parsing arguments
     boost::program_options::options_description partial;
     boost::program_options::positional_options_description positional;
+    std::shared_ptr<PositionalSink> positional_sink; // nullptr if the positional values are stored
+    std::map<std::string, std::shared_ptr<completion::ValueCompleter>> value_completers; // by long names
 
     // These vars are used only for printing help message
     boost::program_options::options_description visible;
@@ -91,6 +146,7 @@ class OptionsGroup
 
   private:
     std::string group_name_;
+    mutable std::shared_ptr<const OptionsSchema> schema_;
     // bool not_specified_{true}; // true if none of the positional or partial
     // options are specified
 };
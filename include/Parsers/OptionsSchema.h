@@ -0,0 +1,59 @@
+#ifndef __OPTIONS_SCHEMA_H__
+#define __OPTIONS_SCHEMA_H__
+
+#include <Completion/ValueCompleter.h>
+
+#include <boost/program_options/options_description.hpp>
+
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+class OptionsSchema
+{
+    // Read-only view of the visible options of a group with all the names
+    // computed once: the names are interned in one pool and exposed as
+    // string_views, the lists as spans. Walking the schema allocates nothing.
+    // OptionsGroup::schema() builds it on first use and rebuilds it after the
+    // group is changed.
+  public:
+    struct Option
+    {
+        std::string_view long_name;              // without "--", empty for the short-only options
+        std::span<const std::string_view> names; // "--long" names, then "-s"; the first one is canonical
+        std::string_view description;
+        // nullptr if the values are not completed, shared so that the users of
+        // the schema may keep the completer after the schema is rebuilt
+        std::shared_ptr<const completion::ValueCompleter> completer;
+    };
+
+    OptionsSchema(const boost::program_options::options_description &visible,
+                  const std::map<std::string, std::shared_ptr<completion::ValueCompleter>> &value_completers);
+    OptionsSchema(const OptionsSchema &) = delete;
+    OptionsSchema &operator=(const OptionsSchema &) = delete;
+
+    std::span<const Option> options() const
+    {
+        return options_;
+    }
+    bool hasValueCompleters() const
+    {
+        return has_value_completers_;
+    }
+
+  private:
+    std::string pool_;
+    std::vector<std::string_view> names_;
+    std::vector<Option> options_;
+    bool has_value_completers_{false};
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __OPTIONS_SCHEMA_H__
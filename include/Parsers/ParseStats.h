@@ -0,0 +1,238 @@
+#ifndef __PARSE_STATS_H__
+#define __PARSE_STATS_H__
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 0 removes the recording of the parse statistics from the parsers at
+// compile time, ParseStats is still available but stays empty. The parsers
+// are compiled in the program_options_heavy library, so the value is chosen
+// by the CMake option PROGRAM_OPTIONS_HEAVY_PARSE_STATS which defines it for
+// the library and its consumers; don't define it in the consumer sources.
+#ifndef PROGRAM_OPTIONS_HEAVY_PARSE_STATS
+#define PROGRAM_OPTIONS_HEAVY_PARSE_STATS 1
+#endif
+
+namespace program_options_heavy
+{
+
+class ParseStats
+{
+    // Timings and counters of the phases of the parse. Install the object
+    // into the parser with setParseStats(); the records of all the following
+    // parses are appended until clear(). ParserWithSubcommands passes its
+    // object to the selected subcommand, so one object collects the whole
+    // invocation. The object is not thread safe: use one per parser.
+  public:
+    static constexpr bool enabled = PROGRAM_OPTIONS_HEAVY_PARSE_STATS != 0;
+
+    enum class Phase
+    {
+        Parse,            // the whole parse() of a parser
+        Dispatch,         // ParserWithSubcommands: selection and instantiation of the subcommand
+        MergeDescription, // options of all the groups merged (cached after the first parse)
+        ResponseFiles,    // @file arguments expanded
+        Tokenize,         // command line matched against the options
+        Store,            // po::store of the command line
+        ConfigSources,    // environment and config file stored
+        Notify,           // po::notify
+        PositionalSink,   // values delivered to the positional sink
+        Update,           // OptionsGroup::update, one record per group
+        Validate          // OptionsGroup::validate, one record per group
+    };
+    struct Record
+    {
+        Phase phase;
+        std::string parser; // exename of the parser
+        std::string detail; // name of the group for Update and Validate, name of the subcommand for Dispatch
+        uint64_t start_ns;  // since the construction or clear()
+        uint64_t duration_ns;
+        size_t options_matched;
+        std::optional<uint64_t> allocations; // if the allocations counter is installed
+    };
+
+    static std::string_view phaseName(Phase phase)
+    {
+        static constexpr std::string_view names[] = {"parse",  "dispatch", "merge description", "response files",
+                                                     "tokenize", "store",   "config sources",    "notify",
+                                                     "positional sink", "update", "validate"};
+        return names[static_cast<size_t>(phase)];
+    }
+    // The parsers check the statistics with active(stats), so all the
+    // recording is compiled out if the statistics are disabled
+    static bool active(const ParseStats *stats)
+    {
+        return enabled && stats != nullptr;
+    }
+
+    // counter() returns the number of allocations made so far, e.g. from
+    // the replaced global operator new
+    void setAllocationsCounter(std::function<uint64_t()> counter)
+    {
+        allocations_counter_ = std::move(counter);
+    }
+    const std::vector<Record> &records() const
+    {
+        return records_;
+    }
+    uint64_t totalNanoseconds(Phase phase) const
+    {
+        uint64_t res = 0;
+        for (const auto &it : records_)
+        {
+            if (it.phase == phase)
+            {
+                res += it.duration_ns;
+            }
+        }
+        return res;
+    }
+    void clear()
+    {
+        records_.clear();
+        epoch_ = clock::now();
+    }
+
+    // Chrome trace event format, load the file in chrome://tracing or
+    // https://ui.perfetto.dev. Nested phases are shown nested.
+    void writeChromeTrace(std::ostream &os) const
+    {
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        for (size_t n = 0; n < records_.size(); n++)
+        {
+            const Record &it = records_[n];
+            os << (n ? ",\n" : "\n") << "{\"name\":";
+            writeString(os, phaseName(it.phase));
+            os << ",\"cat\":\"parse\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":";
+            writeMicroseconds(os, it.start_ns);
+            os << ",\"dur\":";
+            writeMicroseconds(os, it.duration_ns);
+            os << ",\"args\":{\"parser\":";
+            writeString(os, it.parser);
+            if (!it.detail.empty())
+            {
+                os << ",\"detail\":";
+                writeString(os, it.detail);
+            }
+            os << ",\"options_matched\":" << it.options_matched;
+            if (it.allocations.has_value())
+            {
+                os << ",\"allocations\":" << it.allocations.value();
+            }
+            os << "}}";
+        }
+        os << "\n]}\n";
+    }
+    std::string chromeTrace() const
+    {
+        std::ostringstream res;
+        writeChromeTrace(res);
+        return res.str();
+    }
+
+    class Scope
+    {
+        // Records the phase from the construction till the destruction,
+        // does nothing if stats is nullptr
+      public:
+        Scope(ParseStats *stats, Phase phase, std::string_view parser, std::string_view detail = {})
+            : stats_{active(stats) ? stats : nullptr}
+        {
+            if (stats_)
+            {
+                record_ = Record{phase, std::string(parser), std::string(detail), 0, 0, 0, stats_->allocations()};
+                start_ = clock::now();
+            }
+        }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+        ~Scope()
+        {
+            if (stats_)
+            {
+                auto end = clock::now();
+                record_.start_ns = nanoseconds(start_ - stats_->epoch_);
+                record_.duration_ns = nanoseconds(end - start_);
+                if (record_.allocations.has_value())
+                {
+                    record_.allocations = stats_->allocations().value() - record_.allocations.value();
+                }
+                stats_->records_.push_back(std::move(record_));
+            }
+        }
+        void setOptionsMatched(size_t count)
+        {
+            record_.options_matched = count;
+        }
+        void setDetail(std::string_view detail)
+        {
+            if (stats_)
+            {
+                record_.detail = detail;
+            }
+        }
+
+      private:
+        ParseStats *stats_;
+        Record record_{};
+        std::chrono::steady_clock::time_point start_;
+    };
+
+  private:
+    using clock = std::chrono::steady_clock;
+    std::vector<Record> records_;
+    clock::time_point epoch_{clock::now()};
+    std::function<uint64_t()> allocations_counter_;
+
+    std::optional<uint64_t> allocations() const
+    {
+        if (!allocations_counter_)
+        {
+            return std::nullopt;
+        }
+        return allocations_counter_();
+    }
+    static uint64_t nanoseconds(clock::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+    // the trace timestamps are microseconds
+    static void writeMicroseconds(std::ostream &os, uint64_t ns)
+    {
+        char frac[4] = {static_cast<char>('0' + ns / 100 % 10), static_cast<char>('0' + ns / 10 % 10),
+                        static_cast<char>('0' + ns % 10), '\0'};
+        os << ns / 1000 << '.' << frac;
+    }
+    static void writeString(std::ostream &os, std::string_view str)
+    {
+        static constexpr char hex[] = "0123456789abcdef";
+        os << '"';
+        for (char ch : str)
+        {
+            if (ch == '"' || ch == '\\')
+            {
+                os << '\\' << ch;
+            }
+            else if (static_cast<unsigned char>(ch) < 0x20)
+            {
+                os << "\\u00" << hex[ch >> 4] << hex[ch & 15];
+            }
+            else
+            {
+                os << ch;
+            }
+        }
+        os << '"';
+    }
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __PARSE_STATS_H__
@@ -2,19 +2,23 @@
 #define __PROGRAM_OPTIONS_PARSER_H__
 
 #include <Parsers/AbstractOptionsParser.h>
+#include <Parsers/ConfigSources.h>
 #include <Parsers/OptionsGroup.h>
+#include <Parsers/ResponseFile.h>
 
-#include <iostream>
-#include <locale>
-#include <map>
-#include <set>
-#include <sstream>
+#include <memory>
+#include <optional>
 #include <string>
-#include <variant>
+#include <vector>
 
 namespace program_options_heavy
 {
 
+namespace detail
+{
+struct MergedDescription;
+} /* namespace detail */
+
 class Parser : public AbstractOptionsParser
 {
     // This class can parse the list of options and print the help message
@@ -27,62 +31,56 @@ class Parser : public AbstractOptionsParser
     Parser(int argc, const char *argv[]) : AbstractOptionsParser(argc, argv)
     {
     }
-    virtual void addGroup(std::shared_ptr<OptionsGroup> options)
+    virtual void addGroup(std::shared_ptr<OptionsGroup> options);
+    // Arguments @file are replaced by the arguments listed in the file, see
+    // ResponseFileExpander
+    void enableResponseFiles(const ResponseFileOptions &options = {})
     {
-        if (options->positional.max_total_count() != 0)
-        {
-            for (auto it : groups_)
-            {
-                // only one group of options is allowed to have positional
-                // arguments
-                assert(it->positional.max_total_count() == 0);
-            }
-        }
-        groups_.push_back(options);
+        response_files_ = options;
     }
-    bool parse(int argc, const char *argv[]) override
+    // The values missing in the command line are taken from the environment
+    // and the config file, see ConfigSources. The environment is scanned by
+    // the first parse and reused by the following ones while the prefix is
+    // the same, see rescanEnvironment().
+    void setConfigSources(const ConfigSources &sources)
     {
-        namespace po = boost::program_options;
-        boost::program_options::options_description partial;
-        boost::program_options::positional_options_description positional;
-        for (auto it : groups_)
-        {
-            partial.add(it->partial);
-            if (it->positional.max_total_count() != 0)
-            {
-                // only one group of options is allowed to have positional
-                // arguments
-                assert(positional.max_total_count() == 0);
-                positional = it->positional;
-            }
-        }
-        boost::program_options::variables_map vm;
-        auto parse_results = po::command_line_parser(argc, argv).options(partial).positional(positional).run();
-        po::store(parse_results, vm);
-        boost::program_options::notify(vm);
-        for (auto it : groups_)
-        {
-            it->update(vm);
-        }
-        activated = true;
-        return true;
+        config_sources_ = sources;
     }
-    void validate() override
+    // The next parse sees the changes of the environment made after the
+    // environment was scanned
+    void rescanEnvironment()
     {
-        for (auto it : groups_)
-            it->validate();
+        environment_.reset();
     }
+    bool parse(int argc, const char *argv[]) override;
+    void validate() override;
     void update(const boost::program_options::variables_map &vm) override
     {
     }
-    const std::vector<std::shared_ptr<OptionsGroup>> groups() const
+    const std::vector<std::shared_ptr<OptionsGroup>> &groups() const
     {
         return groups_;
     }
+    // The values stored by the last successful parse
+    const boost::program_options::variables_map &values() const
+    {
+        return values_;
+    }
 
     bool activated{false}; // becomes true when parse function succeeded
   private:
     std::vector<std::shared_ptr<OptionsGroup>> groups_;
+    std::optional<ResponseFileOptions> response_files_; // disabled by default
+    std::optional<ConfigSources> config_sources_;        // command line only by default
+    std::shared_ptr<detail::MergedDescription> merged_;  // options of all the groups, built on the first parse
+    boost::program_options::variables_map values_;
+    std::optional<Environment> environment_; // scanned once, see setConfigSources
+
+    size_t optionsCount() const;
+    const detail::MergedDescription &mergedDescription();
+    // Returns the number of the values found in the sources
+    size_t storeConfigSources(const detail::MergedDescription &merged, const ConfigSources &sources,
+                              boost::program_options::variables_map &vm);
 };
 
 } /* namespace program_options_heavy */
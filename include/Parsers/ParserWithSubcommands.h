@@ -2,9 +2,19 @@
 #define __SUBCOMMANDS_PARSER_H__
 
 #include <Parsers/AbstractOptionsParser.h>
+#include <Parsers/NameIndex.h>
 #include <Parsers/OptionsGroup.h>
 #include <Parsers/Parser.h>
 
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace program_options_heavy
 {
 
@@ -13,8 +23,27 @@ class ProgramSubcommandsPrinter;
 class ParserWithSubcommands : public AbstractOptionsParser
 {
   public:
-    using value_t = std::shared_ptr<Parser>;
+    using value_t = std::shared_ptr<Parser>; // nullptr until the lazy subcommand is instantiated
     using subcommands_t = std::map<std::string, value_t>;
+    using factory_t = std::function<std::shared_ptr<Parser>()>;
+    using branch_factory_t = std::function<std::shared_ptr<ParserWithSubcommands>()>;
+
+    struct Subcommand
+    {
+        std::string name{};
+        value_t parser{}; // nullptr for the branches
+        // lazy subcommands only, see addLazy
+        std::string description{};
+        factory_t factory{};
+        // nested level of subcommands, see addBranch
+        std::shared_ptr<ParserWithSubcommands> branch{};
+        branch_factory_t branch_factory{};
+
+        bool isBranch() const
+        {
+            return branch || branch_factory;
+        }
+    };
 
     ParserWithSubcommands(const std::string &exename = "") : AbstractOptionsParser(exename)
     {
@@ -22,104 +51,73 @@ class ParserWithSubcommands : public AbstractOptionsParser
     ParserWithSubcommands(int argc, const char *argv[]) : AbstractOptionsParser(argc, argv)
     {
     }
-    subcommands_t getSubcommands() {
-        return subcommands_;
-    }
-    std::shared_ptr<Parser> push_back(const std::string &subcommand_name,
-                                                    std::shared_ptr<Parser> val)
+    // Copy of the subcommands by names, prefer subcommands() which copies
+    // nothing. The lazy subcommands are instantiated, the branches are not
+    // included (see branch()).
+    subcommands_t getSubcommands();
+    // The subcommands of getSubcommands() in the order of addition. The
+    // iterators point into a copy kept by the parser, which is built by the
+    // first call and stays valid until a subcommand is added.
+    [[deprecated("use subcommands()")]] std::vector<subcommands_t::iterator> &subcommandsOrder();
+    // All the subcommands in the order of addition, the options of every
+    // subcommand are viewed with groups() and OptionsGroup::schema()
+    const std::vector<Subcommand> &subcommands() const
     {
-        auto res = subcommands_.emplace(subcommand_name, val);
-        if (!res.second)
-        {
-            throw std::runtime_error("The specified subcommand_name is already "
-                                     "present in SubcommandsParser");
-        }
-        subcommands_order_.push_back(subcommands_.find(subcommand_name));
-        return res.first->second;
-    }
-    std::shared_ptr<Parser> operator[](const std::string &subcommand_name)
-    {
-        auto pos = subcommands_.find(subcommand_name);
-        if (pos == subcommands_.end())
-        {
-            pos = subcommands_.emplace(subcommand_name, std::make_shared<Parser>(exename)).first;
-            subcommands_order_.push_back(subcommands_.find(subcommand_name));
-        }
-        return pos->second;
-    }
-    std::shared_ptr<Parser> at(const std::string &subcommand_name)
-    {
-        auto pos = subcommands_.find(subcommand_name);
-        assert(pos != subcommands_.end());
-        return pos->second;
+        return subcommands_;
     }
+    std::shared_ptr<Parser> push_back(const std::string &subcommand_name, std::shared_ptr<Parser> val);
+    // Registers the subcommand which Parser is built by the factory only when
+    // the subcommand is selected or accessed. Until then the help message and
+    // Completer see only the name and the description.
+    void addLazy(const std::string &subcommand_name, const std::string &description, factory_t factory);
+    // Adds the nested level of subcommands: "prog name subcommand ...". The
+    // token after the name is dispatched by the branch, which has its own
+    // subcommands, default subcommand, help and completion.
+    std::shared_ptr<ParserWithSubcommands> addBranch(const std::string &subcommand_name,
+                                                     const std::string &description = "");
+    // The branch is built by the factory only when it is selected or
+    // accessed, like the lazy subcommands
+    void addLazyBranch(const std::string &subcommand_name, const std::string &description,
+                       branch_factory_t factory);
+    // The branch must exist, it is instantiated if needed
+    std::shared_ptr<ParserWithSubcommands> branch(std::string_view subcommand_name);
+    bool contains(std::string_view subcommand_name) const;
+    const Subcommand &subcommand(std::string_view subcommand_name) const;
+    bool isInstantiated(std::string_view subcommand_name) const;
+    // Description of the subcommand without instantiating it
+    const std::string &subcommandDescription(std::string_view subcommand_name) const;
+    // operator[] and at() throw if the subcommand is a branch, see branch()
+    std::shared_ptr<Parser> operator[](const std::string &subcommand_name);
+    std::shared_ptr<Parser> at(std::string_view subcommand_name);
     std::shared_ptr<Parser> defaultSubcommand()
     {
         return at(default_subcommand_name_);
     }
-    void setDefaultSubcommand(const std::string &subcommand_name, bool hide)
-    {
-        assert(subcommands_.contains(subcommand_name));
-        default_subcommand_name_ = subcommand_name;
-        is_default_subcommand_enabled_ = true;
-        hide_default_subcommand_name_ = hide; // if true the default subcommand name will be replaced by
-                                              // empty string in the help message
-    }
+    void setDefaultSubcommand(const std::string &subcommand_name, bool hide);
     const std::string &defaultSubcommandName()
     {
         return default_subcommand_name_;
     }
-    std::shared_ptr<Parser> selectedSubcommand()
-    {
-        return selected_subcommand_->second;
-    }
+    // The parser of the selected leaf subcommand, the branches are walked down
+    std::shared_ptr<Parser> selectedSubcommand();
+    // The name of the subcommand selected at this level
     const std::string &selectedSubcommandName()
     {
-        return selected_subcommand_->first;
-    }
-    bool parse(int argc, const char *argv[]) override
-    {
-        assert(!subcommands_.empty());
-        bool fallback_to_default = true;
-        if (argc >= 2)
-        {
-            const char *first_arg = argv[1];
-            selected_subcommand_ = subcommands_.find(first_arg);
-            if (selected_subcommand_ != subcommands_.end())
-            {
-                argc--;
-                argv++;
-                fallback_to_default = false;
-            };
-        };
-        if (fallback_to_default)
-        {
-            // Subcommand is unknown or no subcommand is specified, select the
-            // default subcommand
-            if (is_default_subcommand_enabled_)
-            {
-                selected_subcommand_ = subcommands_.find(default_subcommand_name_);
-                assert(selected_subcommand_ != subcommands_.end());
-            }
-            else
-            {
-                throw std::runtime_error("Invalid program arguments");
-            }
-        };
-        selected_subcommand_->second->parse(argc, argv);
-        activated = true;
-        return true;
-    }
+        return subcommands_.at(selected_subcommand_).name;
+    }
+    // The names of the subcommands selected at every level separated by
+    // spaces, e.g. "cluster node drain"
+    std::string selectedPath() const;
+    bool parse(int argc, const char *argv[]) override;
+    // The sources are used by the selected subcommand, the environment
+    // prefix is derived from the exename of this parser
+    void setConfigSources(ConfigSources sources);
     void validate() override
     {
     }
     void update(const boost::program_options::variables_map &vm) override
     {
     }
-    std::vector<subcommands_t::iterator> &subcommandsOrder()
-    {
-        return subcommands_order_;
-    }
     bool hideDefaultSubcommandName()
     {
         return hide_default_subcommand_name_;
@@ -127,12 +125,23 @@ class ParserWithSubcommands : public AbstractOptionsParser
 
     bool activated{false}; // becomes true when parse function succeeded
   private:
-    subcommands_t subcommands_;
-    std::vector<subcommands_t::iterator> subcommands_order_; // order of subcommands_ for printing purpose
-    subcommands_t::iterator selected_subcommand_;
+    std::vector<Subcommand> subcommands_; // in the order of addition for printing purpose
+    NameIndex index_;                     // subcommands_ by name
+    size_t selected_subcommand_{static_cast<size_t>(-1)};
     std::string default_subcommand_name_{"default"};
     bool hide_default_subcommand_name_{false};
     bool is_default_subcommand_enabled_{false};
+    std::optional<ConfigSources> config_sources_;
+    subcommands_t compat_subcommands_;                          // see subcommandsOrder()
+    std::vector<subcommands_t::iterator> compat_subcommands_order_;
+
+    std::optional<uint32_t> find(std::string_view subcommand_name) const;
+    Subcommand &add(Subcommand subcmd);
+    // Builds the lazy subcommand or branch, returns the parser of the
+    // subcommand (nullptr for the branches)
+    std::shared_ptr<Parser> instantiate(size_t n);
+    // instantiate() for the subcommands which must not be branches
+    std::shared_ptr<Parser> leaf(size_t n);
     friend class ProgramSubcommandsPrinter;
 };
 
@@ -0,0 +1,140 @@
+#ifndef __POSITIONAL_SINK_H__
+#define __POSITIONAL_SINK_H__
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace program_options_heavy
+{
+
+class PositionalSink
+{
+    // Receives the positional values one by one instead of storing them in the
+    // variables_map (see OptionsGroup::addPositionalSink). The values are
+    // pushed as soon as the parser matches them, before the other options are
+    // stored and validated, and are not copied. The command lines which the
+    // parser leaves to boost (abbreviations, multitoken options, etc.) are
+    // copied whole, there the values are pushed after the command line is
+    // parsed. The value "-" makes the parser read the values
+    // from the input stream (std::cin by default) after the options are
+    // stored, one value per line or terminated by '\0' if nul_delimited is
+    // set (e.g. by --null). The values read from the stream are never stored,
+    // so the memory used does not depend on the number of values.
+    //
+    // Either pass the callback or override push().
+  public:
+    using callback_t = std::function<void(std::string_view)>;
+
+    PositionalSink(callback_t callback) : callback_{std::move(callback)}
+    {
+        if (!callback_)
+        {
+            throw std::invalid_argument("PositionalSink needs a callback");
+        }
+    }
+    virtual ~PositionalSink() = default;
+
+    virtual void push(std::string_view value)
+    {
+        callback_(value);
+    }
+    // Called by the parser before the first value of every parse
+    virtual void open()
+    {
+    }
+    // Called by the parser when all the values are pushed or the parsing failed
+    virtual void close()
+    {
+    }
+    void read(std::istream &in)
+    {
+        std::string value; // reused for all the values
+        while (std::getline(in, value, nul_delimited ? '\0' : '\n'))
+        {
+            push(value);
+        }
+    }
+    void setInput(std::istream &in)
+    {
+        input_ = &in;
+    }
+    std::istream &input()
+    {
+        return *input_;
+    }
+
+    bool nul_delimited{false}; // bound to --null,-0 if requested
+
+  protected:
+    PositionalSink() = default; // for the sinks overriding push()
+
+  private:
+    callback_t callback_;
+    std::istream *input_{&std::cin};
+};
+
+class PositionalQueue : public PositionalSink
+{
+    // Bounded queue of the positional values: the parser blocks while the
+    // queue is full, the consumers take the values with pop() in other
+    // threads, so the processing of the values overlaps the parsing. The
+    // queue is reopened by every parse, pop() returns nullopt after the
+    // values of the parse are taken.
+  public:
+    PositionalQueue(size_t capacity) : capacity_{std::max<size_t>(capacity, 1)}
+    {
+    }
+
+    void push(std::string_view value) override
+    {
+        std::unique_lock lock(mutex_);
+        can_push_.wait(lock, [this]() { return queue_.size() < capacity_; });
+        queue_.emplace_back(value);
+        can_pop_.notify_one();
+    }
+    void close() override
+    {
+        std::lock_guard lock(mutex_);
+        closed_ = true;
+        can_pop_.notify_all();
+    }
+    // Returns nullopt when the parser has pushed all the values
+    std::optional<std::string> pop()
+    {
+        std::unique_lock lock(mutex_);
+        can_pop_.wait(lock, [this]() { return !queue_.empty() || closed_; });
+        if (queue_.empty())
+        {
+            return std::nullopt;
+        }
+        std::string res = std::move(queue_.front());
+        queue_.pop_front();
+        can_push_.notify_one();
+        return res;
+    }
+    void open() override
+    {
+        std::lock_guard lock(mutex_);
+        closed_ = false;
+    }
+
+  private:
+    size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable can_push_;
+    std::condition_variable can_pop_;
+    std::deque<std::string> queue_;
+    bool closed_{false};
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __POSITIONAL_SINK_H__
@@ -0,0 +1,207 @@
+#ifndef __RESPONSE_FILE_H__
+#define __RESPONSE_FILE_H__
+
+#include <Parsers/MappedFile.h>
+
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+struct ResponseFileOptions
+{
+    enum class Delimiter
+    {
+        Whitespace, // arguments are separated by whitespace, quotes and backslash escapes are allowed
+        Nul         // arguments are terminated by '\0' and taken literally (find -print0, xargs -0),
+                    // @file inside the response file is an argument too
+    };
+    Delimiter delimiter{Delimiter::Whitespace};
+    unsigned max_depth{8}; // maximal nesting of @file inside response files, Whitespace only
+};
+
+class ResponseFileError : public std::runtime_error
+{
+  public:
+    ResponseFileError(const std::string &path, size_t offset, const std::string &what)
+        : std::runtime_error(path + ":" + std::to_string(offset) + ": " + what), path{path}, offset{offset}
+    {
+    }
+    std::string path;
+    size_t offset; // position in the file in bytes
+};
+
+class ResponseFileExpander
+{
+    // Replaces the arguments @file by the arguments listed in the file. The
+    // files are mapped into memory and the arguments are returned as views of
+    // the mapped files, only the arguments with quotes or escapes are copied.
+    // The views are valid while the expander is alive. The paths of nested
+    // response files are relative to the current directory as in gcc. The
+    // arguments after "--", given or read from a file, are not expanded. All
+    // the errors, including the missing files, are reported as
+    // ResponseFileError.
+  public:
+    ResponseFileExpander(const ResponseFileOptions &options = {}) : options_{options}
+    {
+    }
+
+    std::vector<std::string_view> expand(const std::vector<std::string_view> &args)
+    {
+        std::vector<std::string_view> res;
+        res.reserve(args.size());
+        literal_ = false;
+        for (auto arg : args)
+        {
+            if (!literal_ && isResponseFile(arg))
+            {
+                std::string path(arg.substr(1));
+                read(map(path, path, 0).data(), path, 1, res);
+            }
+            else
+            {
+                push(arg, res);
+            }
+        }
+        return res;
+    }
+    static bool isResponseFile(std::string_view arg)
+    {
+        return arg.size() > 1 && arg[0] == '@';
+    }
+
+  private:
+    ResponseFileOptions options_;
+    std::deque<MappedFile> files_;     // deque keeps the references valid
+    std::deque<std::string> unescaped_; // the arguments which differ from the text of the file
+    bool literal_{false};               // "--" is passed, the following arguments are not expanded
+
+    void push(std::string_view arg, std::vector<std::string_view> &res)
+    {
+        literal_ = literal_ || arg == "--";
+        res.push_back(arg);
+    }
+
+    void add(std::string_view arg, const std::string &path, size_t offset, unsigned depth,
+             std::vector<std::string_view> &res)
+    {
+        if (literal_ || !isResponseFile(arg))
+        {
+            push(arg, res);
+            return;
+        }
+        if (depth >= options_.max_depth)
+        {
+            throw ResponseFileError(path, offset, "response files are nested too deep");
+        }
+        std::string nested(arg.substr(1));
+        read(map(nested, path, offset).data(), nested, depth + 1, res);
+    }
+    // The error is reported at the offset of the argument @file in the
+    // response file at path
+    const MappedFile &map(const std::string &file, const std::string &path, size_t offset)
+    {
+        try
+        {
+            return files_.emplace_back(std::filesystem::path(file));
+        }
+        catch (const std::runtime_error &e)
+        {
+            throw ResponseFileError(path, offset, e.what());
+        }
+    }
+
+    void read(std::string_view text, const std::string &path, unsigned depth, std::vector<std::string_view> &res)
+    {
+        if (options_.delimiter == ResponseFileOptions::Delimiter::Nul)
+        {
+            for (size_t pos = 0; pos < text.size();)
+            {
+                size_t end = text.find('\0', pos);
+                if (end == std::string_view::npos)
+                {
+                    end = text.size(); // the terminator of the last argument is optional
+                }
+                push(text.substr(pos, end - pos), res);
+                pos = end + 1;
+            }
+            return;
+        }
+        size_t pos = 0;
+        while (true)
+        {
+            while (pos < text.size() && isSpace(text[pos]))
+            {
+                pos++;
+            }
+            if (pos == text.size())
+            {
+                break;
+            }
+            size_t start = pos;
+            while (pos < text.size() && !isSpace(text[pos]) && !isQuoteOrEscape(text[pos]))
+            {
+                pos++;
+            }
+            if (pos == text.size() || isSpace(text[pos]))
+            {
+                add(text.substr(start, pos - start), path, start, depth, res);
+                continue;
+            }
+            // the argument has to be unescaped
+            std::string &arg = unescaped_.emplace_back(text.substr(start, pos - start));
+            char quote = '\0';
+            size_t quote_pos = 0;
+            for (; pos < text.size() && (quote || !isSpace(text[pos])); pos++)
+            {
+                char ch = text[pos];
+                if (quote == '\'' && ch != '\'')
+                {
+                    arg += ch;
+                }
+                else if (ch == '\\' && quote != '\'')
+                {
+                    if (++pos == text.size())
+                    {
+                        throw ResponseFileError(path, pos - 1, "backslash at the end of the file");
+                    }
+                    arg += text[pos];
+                }
+                else if (ch == quote)
+                {
+                    quote = '\0';
+                }
+                else if (!quote && (ch == '\'' || ch == '"'))
+                {
+                    quote = ch;
+                    quote_pos = pos;
+                }
+                else
+                {
+                    arg += ch;
+                }
+            }
+            if (quote)
+            {
+                throw ResponseFileError(path, quote_pos, "unterminated quote");
+            }
+            add(arg, path, start, depth, res);
+        }
+    }
+    static bool isSpace(char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+    }
+    static bool isQuoteOrEscape(char ch)
+    {
+        return ch == '\'' || ch == '"' || ch == '\\';
+    }
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __RESPONSE_FILE_H__
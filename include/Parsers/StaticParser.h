@@ -0,0 +1,463 @@
+#ifndef __STATIC_PARSER_H__
+#define __STATIC_PARSER_H__
+
+#include <Parsers/AbstractOptionsParser.h>
+#include <Printers/Document.h>
+
+#include <boost/program_options/cmdline.hpp>
+#include <boost/program_options/errors.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+// Alternative to Parser for programs which options never change at runtime.
+// Names, short names and value types of the options are template parameters,
+// so nothing is built at startup: the name lookup is a perfect hash computed
+// by the compiler and the help/completion table is a constexpr array.
+//
+//   using Schema = StaticSchema<StaticOption<"dim", 'd', size_t, "hypercube dimension">,
+//                               StaticOption<"verbose", 'v', bool, "print more">>;
+//   StaticParser<Schema> parser(argc, argv);
+//   parser.parse(argc, argv);
+//   size_t dim = parser.get<"dim">().value_or(2);
+
+template <size_t N> struct FixedString
+{
+    char data[N]{};
+    constexpr FixedString(const char (&str)[N])
+    {
+        std::copy_n(str, N, data);
+    }
+    constexpr std::string_view view() const
+    {
+        return std::string_view(data, N - 1);
+    }
+};
+
+// Supported value types: bool (switch), arithmetic types, std::string and
+// std::string_view (points into argv, no copy is made)
+template <FixedString Name, char ShortName, class T, FixedString Description = ""> struct StaticOption
+{
+    using value_type = T;
+    static constexpr std::string_view name = Name.view();
+    static constexpr char short_name = ShortName; // '\0' if the option has no short name
+    static constexpr std::string_view description = Description.view();
+
+    static_assert(!name.empty(), "the long name of the option is required");
+    static_assert(std::is_same_v<T, bool> || std::is_arithmetic_v<T> || std::is_same_v<T, std::string> ||
+                      std::is_same_v<T, std::string_view>,
+                  "unsupported value type of the static option");
+};
+
+template <size_t N> class PerfectHash
+{
+    // Hash and displace: the first hash selects the bucket, the displacement
+    // stored for the bucket is mixed into the hash to get the slot. The
+    // displacements are found by the compiler so that no slots collide.
+  public:
+    static constexpr size_t buckets_count = std::bit_ceil(N / 2 + 1);
+    static constexpr size_t slots_count = std::bit_ceil(N + N / 2 + 1);
+    static constexpr uint32_t empty = static_cast<uint32_t>(-1);
+
+    constexpr PerfectHash(const std::array<std::string_view, N> &keys)
+    {
+        std::array<uint64_t, N> hashes{};
+        std::array<uint32_t, buckets_count + 1> bucket_start{}; // keys sorted by bucket: counting sort
+        std::array<uint32_t, N> sorted{};
+        for (size_t n = 0; n < N; n++)
+        {
+            hashes[n] = hash(keys[n]);
+            bucket_start[bucketOf(hashes[n]) + 1]++;
+        }
+        size_t max_bucket_size = 0;
+        for (size_t b = 0; b < buckets_count; b++)
+        {
+            max_bucket_size = std::max<size_t>(max_bucket_size, bucket_start[b + 1]);
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        std::array<uint32_t, buckets_count> fill{};
+        for (size_t n = 0; n < N; n++)
+        {
+            size_t b = bucketOf(hashes[n]);
+            sorted[bucket_start[b] + fill[b]++] = static_cast<uint32_t>(n);
+        }
+        slots_.fill(empty);
+        // the biggest buckets are placed first while there are many free slots
+        for (size_t size = max_bucket_size; size > 0; size--)
+        {
+            for (size_t b = 0; b < buckets_count; b++)
+            {
+                if (bucket_start[b + 1] - bucket_start[b] == size)
+                {
+                    place(b, hashes, std::span<const uint32_t>(sorted).subspan(bucket_start[b], size));
+                }
+            }
+        }
+    }
+
+    // Index of the key or empty, the caller must compare the key itself
+    constexpr uint32_t find(std::string_view key) const
+    {
+        uint64_t h = hash(key);
+        return slots_[slotOf(h, displacement_[bucketOf(h)])];
+    }
+
+    static constexpr uint64_t hash(std::string_view key)
+    {
+        uint64_t res = 14695981039346656037ull; // FNV-1a
+        for (char ch : key)
+        {
+            res = (res ^ static_cast<unsigned char>(ch)) * 1099511628211ull;
+        }
+        return mix(res); // the high bits of FNV-1a are poor for short keys
+    }
+
+  private:
+    std::array<uint32_t, buckets_count> displacement_{};
+    std::array<uint32_t, slots_count> slots_{};
+
+    static constexpr size_t bucketOf(uint64_t h)
+    {
+        return (h >> 32) & (buckets_count - 1);
+    }
+    static constexpr uint64_t mix(uint64_t h)
+    {
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull; // splitmix64 finalizer
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+        return h ^ (h >> 31);
+    }
+    static constexpr size_t slotOf(uint64_t h, uint32_t displacement)
+    {
+        return mix(h ^ (displacement * 0x9e3779b97f4a7c15ull)) & (slots_count - 1);
+    }
+    constexpr void place(size_t bucket, const std::array<uint64_t, N> &hashes, std::span<const uint32_t> keys)
+    {
+        for (size_t n = 0; n < keys.size(); n++)
+        {
+            for (size_t m = 0; m < n; m++)
+            {
+                if (hashes[keys[n]] == hashes[keys[m]])
+                {
+                    throw std::logic_error("duplicate option names in StaticSchema");
+                }
+            }
+        }
+        for (uint32_t displacement = 0;; displacement++)
+        {
+            bool ok = true;
+            for (size_t n = 0; n < keys.size() && ok; n++)
+            {
+                size_t slot = slotOf(hashes[keys[n]], displacement);
+                ok = slots_[slot] == empty;
+                for (size_t m = 0; m < n && ok; m++)
+                {
+                    ok = slotOf(hashes[keys[m]], displacement) != slot;
+                }
+            }
+            if (ok)
+            {
+                displacement_[bucket] = displacement;
+                for (auto key : keys)
+                {
+                    slots_[slotOf(hashes[key], displacement)] = key;
+                }
+                return;
+            }
+        }
+    }
+};
+
+template <class... Options> class StaticSchema
+{
+  public:
+    static constexpr size_t size = sizeof...(Options);
+    using values_t = std::tuple<std::optional<typename Options::value_type>...>;
+
+    struct OptionInfo
+    {
+        std::string_view name;
+        char short_name;
+        std::string_view description;
+        bool is_switch;
+    };
+    // static help/completion table
+    static constexpr std::array<OptionInfo, size> options{
+        OptionInfo{Options::name, Options::short_name, Options::description,
+                   std::is_same_v<typename Options::value_type, bool>}...};
+
+    // index of the option with the given long name
+    static constexpr std::optional<size_t> find(std::string_view name)
+    {
+        uint32_t idx = perfect_hash_.find(name);
+        if (idx == PerfectHash<size>::empty || options[idx].name != name)
+        {
+            return std::nullopt;
+        }
+        return idx;
+    }
+    // index of the option with the given short name
+    static constexpr std::optional<size_t> findShort(char short_name)
+    {
+        uint32_t idx = short_names_[static_cast<unsigned char>(short_name)];
+        if (idx == PerfectHash<size>::empty)
+        {
+            return std::nullopt;
+        }
+        return idx;
+    }
+    template <FixedString Name> static consteval size_t indexOf()
+    {
+        auto idx = find(Name.view());
+        if (!idx.has_value())
+        {
+            throw std::logic_error("unknown option name");
+        }
+        return idx.value();
+    }
+
+  private:
+    static constexpr PerfectHash<size> perfect_hash_{std::array<std::string_view, size>{Options::name...}};
+    static constexpr std::array<uint32_t, 256> short_names_ = []() {
+        std::array<uint32_t, 256> res;
+        res.fill(PerfectHash<size>::empty);
+        for (uint32_t n = 0; n < size; n++)
+        {
+            if (options[n].short_name != '\0')
+            {
+                auto &slot = res[static_cast<unsigned char>(options[n].short_name)];
+                if (slot != PerfectHash<size>::empty)
+                {
+                    throw std::logic_error("duplicate short option names in StaticSchema");
+                }
+                slot = n;
+            }
+        }
+        return res;
+    }();
+};
+
+template <class Schema> class StaticParser : public AbstractOptionsParser
+{
+  public:
+    StaticParser(const std::string &exename = "") : AbstractOptionsParser(exename)
+    {
+    }
+    StaticParser(int argc, const char *argv[]) : AbstractOptionsParser(argc, argv)
+    {
+    }
+
+    // Supported syntax: --name value, --name=value, -n value, -nvalue,
+    // --switch, -s, the clusters of short switches -abc (the last option of
+    // the cluster may take the value: -abn value, -abnvalue) and "--" which
+    // ends the options. The rest of arguments are stored as positional ones.
+    bool parse(int argc, const char *argv[]) override
+    {
+        namespace po = boost::program_options;
+        values_ = {};
+        positional_.clear();
+        bool options_ended = false;
+        for (int n = 1; n < argc; n++)
+        {
+            std::string_view arg = argv[n];
+            if (options_ended || arg.size() < 2 || arg[0] != '-')
+            {
+                positional_.push_back(arg);
+                continue;
+            }
+            if (arg == "--")
+            {
+                options_ended = true;
+                continue;
+            }
+            if (arg[1] != '-')
+            {
+                n = parseShort(argc, argv, n);
+                continue;
+            }
+            std::optional<std::string_view> value;
+            std::string_view name = arg.substr(2);
+            if (auto eq = name.find('='); eq != std::string_view::npos)
+            {
+                value = name.substr(eq + 1);
+                name = name.substr(0, eq);
+            }
+            auto idx = Schema::find(name);
+            if (!idx.has_value())
+            {
+                throw po::unknown_option(std::string(arg));
+            }
+            if (!value.has_value() && !Schema::options[idx.value()].is_switch)
+            {
+                value = nextValue(argc, argv, n, name);
+            }
+            setValue(idx.value(), value.value_or(std::string_view()));
+        }
+        activated = true;
+        return true;
+    }
+    void validate() override
+    {
+    }
+    void update(const boost::program_options::variables_map &vm) override
+    {
+    }
+
+    template <FixedString Name> const auto &get() const
+    {
+        return std::get<Schema::template indexOf<Name>()>(values_);
+    }
+    const std::vector<std::string_view> &positional() const
+    {
+        return positional_;
+    }
+
+    // names of every option for CompletionIndex::addCommand
+    static std::vector<std::vector<std::string>> completionNames()
+    {
+        std::vector<std::vector<std::string>> res;
+        for (const auto &opt : Schema::options)
+        {
+            std::vector<std::string> names{"--" + std::string(opt.name)};
+            if (opt.short_name != '\0')
+            {
+                names.push_back(std::string("-") + opt.short_name);
+            }
+            res.push_back(std::move(names));
+        }
+        return res;
+    }
+    // help message built from the static table
+    static std::shared_ptr<printers::Section> help(const std::string &title)
+    {
+        auto document = printers::Document::create();
+        auto res = document->make<printers::Section>();
+        res->setTitle(title);
+        auto list = res->add<printers::UnorderedList>();
+        for (const auto &opt : Schema::options)
+        {
+            std::string line = "--" + std::string(opt.name);
+            if (opt.short_name != '\0')
+            {
+                line += std::string(" [ -") + opt.short_name + " ]";
+            }
+            if (!opt.is_switch)
+            {
+                line += " arg";
+            }
+            line += "\t" + std::string(opt.description);
+            list->add(line);
+        }
+        return document->share(res);
+    }
+
+    bool activated{false}; // becomes true when parse function succeeded
+  private:
+    typename Schema::values_t values_;
+    std::vector<std::string_view> positional_;
+
+    // Parses argv[n] starting with a single '-', returns the index of the
+    // last argument used
+    int parseShort(int argc, const char *argv[], int n)
+    {
+        std::string_view arg = argv[n];
+        for (size_t ch = 1; ch < arg.size(); ch++)
+        {
+            auto idx = Schema::findShort(arg[ch]);
+            if (!idx.has_value())
+            {
+                throw boost::program_options::unknown_option(ch == 1 ? std::string(arg)
+                                                                     : std::string("-") + arg[ch]);
+            }
+            if (Schema::options[idx.value()].is_switch)
+            {
+                setValue(idx.value(), std::string_view());
+                continue;
+            }
+            // the rest of the argument or the next argument is the value
+            std::string name{'-', arg[ch]};
+            setValue(idx.value(), ch + 1 < arg.size() ? arg.substr(ch + 1) : nextValue(argc, argv, n, name));
+            break;
+        }
+        return n;
+    }
+    static std::string_view nextValue(int argc, const char *argv[], int &n, std::string_view name)
+    {
+        namespace po = boost::program_options;
+        if (n + 1 >= argc)
+        {
+            throw po::invalid_command_line_syntax(po::invalid_command_line_syntax::missing_parameter,
+                                                  std::string(name));
+        }
+        return argv[++n];
+    }
+
+    using setter_t = void (*)(StaticParser &, std::string_view);
+    template <size_t... Is> static constexpr std::array<setter_t, Schema::size> makeSetters(std::index_sequence<Is...>)
+    {
+        return {&StaticParser::template setValue<Is>...};
+    }
+    // dispatch by the option index through the constexpr table of setters
+    void setValue(size_t idx, std::string_view str)
+    {
+        static constexpr auto setters = makeSetters(std::make_index_sequence<Schema::size>());
+        setters[idx](*this, str);
+    }
+
+    template <size_t Idx> static void setValue(StaticParser &parser, std::string_view str)
+    {
+        auto &dest = std::get<Idx>(parser.values_);
+        using T = typename std::remove_reference_t<decltype(dest)>::value_type;
+        dest = convert<T>(Schema::options[Idx].name, str);
+    }
+    template <class T> static T convert(std::string_view name, std::string_view str)
+    {
+        namespace po = boost::program_options;
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            if (str.empty() || str == "1" || str == "true" || str == "yes" || str == "on")
+            {
+                return true;
+            }
+            if (str == "0" || str == "false" || str == "no" || str == "off")
+            {
+                return false;
+            }
+        }
+        else if constexpr (std::is_arithmetic_v<T>)
+        {
+            T res{};
+            auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), res);
+            if (ec == std::errc() && ptr == str.data() + str.size())
+            {
+                return res;
+            }
+        }
+        else
+        {
+            return T(str);
+        }
+        po::invalid_option_value error{std::string(str)};
+        error.set_option_name(std::string(name));
+        error.set_prefix(po::command_line_style::allow_long); // shown as --name
+        throw error;
+    }
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __STATIC_PARSER_H__
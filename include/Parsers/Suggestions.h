@@ -0,0 +1,196 @@
+#ifndef __SUGGESTIONS_H__
+#define __SUGGESTIONS_H__
+
+#include <boost/program_options/errors.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+class EditDistance
+{
+    // Levenshtein distance from the query to many candidates. The query is
+    // preprocessed once into the match bit masks, then every candidate costs
+    // a few word operations per character (Myers' bit-parallel algorithm in
+    // Hyyro's formulation for the global distance). Candidates which can't be
+    // closer than max_distance are rejected by their length or as soon as the
+    // remaining characters can't bring the distance back under the bound.
+  public:
+    EditDistance(std::string_view query, size_t max_distance) : query_{query}, max_distance_{max_distance}
+    {
+        if (query_.size() <= 64)
+        {
+            for (size_t n = 0; n < query_.size(); n++)
+            {
+                peq_[static_cast<unsigned char>(query_[n])] |= uint64_t(1) << n;
+            }
+        }
+    }
+
+    // Returns max_distance + 1 if the distance is greater than max_distance
+    size_t operator()(std::string_view candidate) const
+    {
+        size_t m = query_.size();
+        size_t n = candidate.size();
+        size_t length_diff = m > n ? m - n : n - m;
+        if (length_diff > max_distance_)
+        {
+            return max_distance_ + 1;
+        }
+        if (m == 0)
+        {
+            return n;
+        }
+        if (m > 64)
+        {
+            return dynamic(candidate);
+        }
+        uint64_t pv = ~uint64_t(0);
+        uint64_t mv = 0;
+        uint64_t last = uint64_t(1) << (m - 1);
+        size_t score = m;
+        for (size_t j = 0; j < n; j++)
+        {
+            uint64_t eq = peq_[static_cast<unsigned char>(candidate[j])];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            if (ph & last)
+            {
+                score++;
+            }
+            else if (mh & last)
+            {
+                score--;
+            }
+            // every remaining character changes the distance by one at most
+            if (score > max_distance_ + (n - j - 1))
+            {
+                return max_distance_ + 1;
+            }
+            ph = (ph << 1) | 1; // the distance to the empty prefix of the query grows
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+        }
+        return std::min(score, max_distance_ + 1);
+    }
+
+  private:
+    std::string_view query_;
+    size_t max_distance_;
+    std::array<uint64_t, 256> peq_{};
+
+    // the queries longer than a machine word are rare
+    size_t dynamic(std::string_view candidate) const
+    {
+        std::vector<size_t> row(query_.size() + 1);
+        for (size_t i = 0; i < row.size(); i++)
+        {
+            row[i] = i;
+        }
+        for (size_t j = 0; j < candidate.size(); j++)
+        {
+            size_t diag = row[0];
+            row[0] = j + 1;
+            for (size_t i = 1; i < row.size(); i++)
+            {
+                size_t up = row[i];
+                row[i] = std::min({row[i] + 1, row[i - 1] + 1, diag + (query_[i - 1] == candidate[j] ? 0 : 1)});
+                diag = up;
+            }
+        }
+        return std::min(row.back(), max_distance_ + 1);
+    }
+};
+
+// The names closest to the mistyped one, at most max_count of them. The
+// default bound allows about one typo per three characters.
+template <class Names>
+std::vector<std::string> suggestions(std::string_view query, const Names &names, size_t max_count = 3,
+                                     size_t max_distance = 0)
+{
+    if (max_distance == 0)
+    {
+        max_distance = std::max<size_t>(1, query.size() / 3);
+    }
+    EditDistance distance(query, max_distance);
+    std::vector<std::pair<size_t, std::string_view>> found;
+    for (const auto &it : names)
+    {
+        std::string_view name = it;
+        size_t d = distance(name);
+        if (d <= max_distance)
+        {
+            found.emplace_back(d, name);
+        }
+    }
+    std::sort(found.begin(), found.end());
+    found.resize(std::min(found.size(), max_count));
+    std::vector<std::string> res;
+    for (const auto &it : found)
+    {
+        res.emplace_back(it.second);
+    }
+    return res;
+}
+
+// " Did you mean 'a' or 'b'?" or empty string
+inline std::string didYouMean(const std::vector<std::string> &names, std::string_view prefix = "")
+{
+    if (names.empty())
+    {
+        return "";
+    }
+    std::string res = " Did you mean ";
+    for (size_t n = 0; n < names.size(); n++)
+    {
+        if (n > 0)
+        {
+            res += n + 1 == names.size() ? " or " : ", ";
+        }
+        res.append("'").append(prefix).append(names[n]).append("'");
+    }
+    return res + "?";
+}
+
+class UnknownSubcommand : public std::runtime_error
+{
+  public:
+    UnknownSubcommand(const std::string &name, std::vector<std::string> suggestions)
+        : std::runtime_error("Invalid program arguments: unknown subcommand '" + name + "'." +
+                             didYouMean(suggestions)),
+          name{name}, suggestions{std::move(suggestions)}
+    {
+    }
+    std::string name;
+    std::vector<std::string> suggestions;
+};
+
+class UnknownOption : public boost::program_options::unknown_option
+{
+    // boost::program_options::unknown_option with the suggestions appended to
+    // the message
+  public:
+    UnknownOption(const boost::program_options::unknown_option &e, std::vector<std::string> suggestions)
+        : boost::program_options::unknown_option(e), suggestions{std::move(suggestions)}
+    {
+        m_error_template += didYouMean(this->suggestions, "--");
+    }
+    ~UnknownOption() throw()
+    {
+    }
+    std::vector<std::string> suggestions; // long names without dashes
+};
+
+} /* namespace program_options_heavy */
+
+#endif // __SUGGESTIONS_H__
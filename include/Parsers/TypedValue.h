@@ -0,0 +1,415 @@
+#ifndef __TYPED_VALUE_H__
+#define __TYPED_VALUE_H__
+
+#include <boost/any.hpp>
+#include <boost/program_options/errors.hpp>
+#include <boost/program_options/value_semantic.hpp>
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <ratio>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+// The value of the option is rejected by TypedValue, the message tells why:
+// "the argument ('12x') for option '--dim' is invalid: unexpected character 'x'"
+class InvalidValue : public boost::program_options::invalid_option_value
+{
+  public:
+    InvalidValue(const std::string &token, const std::string &reason);
+    const std::string &reason() const
+    {
+        return reason_;
+    }
+
+  private:
+    std::string reason_;
+};
+
+namespace detail
+{
+
+template <class T> struct IsDuration : std::false_type
+{
+};
+template <class Rep, class Period> struct IsDuration<std::chrono::duration<Rep, Period>> : std::true_type
+{
+};
+
+// The parsers return false and set error to the reason if the token is
+// invalid; nothing is allocated if it is valid
+bool parseBool(std::string_view token, bool &value, std::string &error);
+bool parseDurationUnit(std::string_view unit, intmax_t &num, intmax_t &den, std::string &error);
+std::string unexpectedCharacter(std::string_view token, const char *pos);
+
+template <class T> std::string formatNumber(T value)
+{
+    char buf[64];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    return std::string(buf, res.ptr);
+}
+
+template <class T> bool parseNumber(std::string_view token, T &value, std::string &error)
+{
+    if (token.starts_with('+') && token.size() > 1 && token[1] != '-')
+    {
+        token.remove_prefix(1); // from_chars does not accept the plus sign
+    }
+    const char *end = token.data() + token.size();
+    std::from_chars_result res;
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        res = std::from_chars(token.data(), end, value);
+    }
+    else
+    {
+        res = std::from_chars(token.data(), end, value, 10);
+    }
+    if (res.ec == std::errc::result_out_of_range)
+    {
+        error = "out of range [" + formatNumber(std::numeric_limits<T>::lowest()) + ", " +
+                formatNumber(std::numeric_limits<T>::max()) + "]";
+        return false;
+    }
+    if (res.ec != std::errc())
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            error = "expected a number";
+        }
+        else
+        {
+            error = std::is_signed_v<T> ? "expected an integer" : "expected a non-negative integer";
+        }
+        return false;
+    }
+    if (res.ptr != end)
+    {
+        error = unexpectedCharacter(token, res.ptr);
+        return false;
+    }
+    return true;
+}
+
+// "250ms", "2h"; the count of an integral duration must be an integer and
+// the value must be exact in its period ("1500us" is not in milliseconds)
+template <class Duration> bool parseDuration(std::string_view token, Duration &value, std::string &error)
+{
+    using rep = typename Duration::rep;
+    using count_t = std::conditional_t<std::is_floating_point_v<rep>, double, intmax_t>;
+    size_t unit_pos = token.find_first_not_of(std::is_floating_point_v<rep> ? "+-0123456789.eE" : "+-0123456789");
+    if (unit_pos == std::string_view::npos)
+    {
+        error = "missing unit (ns, us, ms, s, min, h, d)";
+        return false;
+    }
+    if (unit_pos == 0)
+    {
+        error = "expected a count followed by a unit (ns, us, ms, s, min, h, d)";
+        return false;
+    }
+    count_t count;
+    intmax_t num;
+    intmax_t den;
+    if (!parseNumber(token.substr(0, unit_pos), count, error) ||
+        !parseDurationUnit(token.substr(unit_pos), num, den, error))
+    {
+        return false;
+    }
+    // the unit in the periods of the destination: num / den
+    num *= Duration::period::den;
+    den *= Duration::period::num;
+    if constexpr (std::is_floating_point_v<rep>)
+    {
+        value = Duration(static_cast<rep>(count * static_cast<double>(num) / static_cast<double>(den)));
+        return true;
+    }
+    else
+    {
+        if (count > std::numeric_limits<intmax_t>::max() / num || count < std::numeric_limits<intmax_t>::min() / num)
+        {
+            error = "out of range";
+            return false;
+        }
+        intmax_t res = count * num;
+        if (res % den != 0)
+        {
+            error = "not a whole number of the duration periods";
+            return false;
+        }
+        res /= den;
+        if (res < std::numeric_limits<rep>::lowest() || res > std::numeric_limits<rep>::max())
+        {
+            error = "out of range";
+            return false;
+        }
+        value = Duration(static_cast<rep>(res));
+        return true;
+    }
+}
+
+template <class Duration> std::string formatDuration(Duration value)
+{
+    using period = typename Duration::period;
+    std::string count = formatNumber(value.count());
+    if constexpr (std::ratio_equal_v<period, std::nano>)
+        return count + "ns";
+    else if constexpr (std::ratio_equal_v<period, std::micro>)
+        return count + "us";
+    else if constexpr (std::ratio_equal_v<period, std::milli>)
+        return count + "ms";
+    else if constexpr (std::ratio_equal_v<period, std::ratio<1>>)
+        return count + "s";
+    else if constexpr (std::ratio_equal_v<period, std::ratio<60>>)
+        return count + "min";
+    else if constexpr (std::ratio_equal_v<period, std::ratio<3600>>)
+        return count + "h";
+    else
+        return formatNumber(std::chrono::duration_cast<std::chrono::duration<double>>(value).count()) + "s";
+}
+
+} /* namespace detail */
+
+template <class T> class TypedValue : public boost::program_options::value_semantic_codecvt_helper<char>,
+                                      public boost::program_options::typed_value_base
+{
+    // Value semantic of the integers, floating point numbers, bools,
+    // std::chrono::durations and enums (see enumValue), a faster drop-in for
+    // po::value<T>: the token is parsed with std::from_chars instead of
+    // lexical_cast and iostreams, and the invalid tokens are reported with
+    // InvalidValue telling the reason. The parsed value is kept in the
+    // variables_map (count() and the precedence of the config sources rely on
+    // it) and is assigned to the bound variable by notify() as usual.
+    //
+    // The modifiers are named after the ones of po::typed_value, so
+    //     po::value<size_t>(&dim)->default_value(2)
+    // becomes
+    //     typedValue(&dim)->default_value(2)
+    // The default and implicit values are shown in the help without
+    // lexical_cast as well.
+  public:
+    static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || detail::IsDuration<T>::value,
+                  "TypedValue supports the numbers, bools, durations and enums");
+    using names_t = std::vector<std::pair<std::string, T>>;
+
+    TypedValue(T *store, names_t names = {}) : store_{store}, names_{std::move(names)}
+    {
+        if constexpr (std::is_enum_v<T>)
+        {
+            for (const auto &it : names_)
+            {
+                value_name_ += (value_name_.empty() ? "" : "|") + it.first;
+            }
+        }
+    }
+
+    TypedValue *default_value(const T &value)
+    {
+        return default_value(value, format(value));
+    }
+    TypedValue *default_value(const T &value, const std::string &text)
+    {
+        default_value_ = value;
+        default_text_ = text;
+        return this;
+    }
+    // The value of the option given without a value (--opt instead of --opt=val)
+    TypedValue *implicit_value(const T &value)
+    {
+        return implicit_value(value, format(value));
+    }
+    TypedValue *implicit_value(const T &value, const std::string &text)
+    {
+        implicit_value_ = value;
+        implicit_text_ = text;
+        return this;
+    }
+    TypedValue *value_name(const std::string &name)
+    {
+        value_name_ = name;
+        return this;
+    }
+    TypedValue *notifier(std::function<void(const T &)> callback)
+    {
+        notifier_ = std::move(callback);
+        return this;
+    }
+    TypedValue *required()
+    {
+        required_ = true;
+        return this;
+    }
+
+    std::string name() const override
+    {
+        const std::string &var = value_name_.empty() ? boost::program_options::arg : value_name_;
+        std::string res = var;
+        if (!implicit_value_.empty())
+        {
+            res = "[=" + var + "(=" + implicit_text_ + ")]";
+        }
+        if (!default_value_.empty())
+        {
+            res += " (=" + default_text_ + ")";
+        }
+        return res;
+    }
+    unsigned min_tokens() const override
+    {
+        return implicit_value_.empty() ? 1 : 0;
+    }
+    unsigned max_tokens() const override
+    {
+        return 1;
+    }
+    bool is_composing() const override
+    {
+        return false;
+    }
+    bool is_required() const override
+    {
+        return required_;
+    }
+    bool apply_default(boost::any &value_store) const override
+    {
+        if (default_value_.empty())
+        {
+            return false;
+        }
+        value_store = default_value_;
+        return true;
+    }
+    void notify(const boost::any &value_store) const override
+    {
+        const T &value = *boost::any_cast<T>(&value_store);
+        if (store_)
+        {
+            *store_ = value;
+        }
+        if (notifier_)
+        {
+            notifier_(value);
+        }
+    }
+    const std::type_info &value_type() const override
+    {
+        return typeid(T);
+    }
+
+    // Parses the token, returns false and sets error to the reason if it is
+    // invalid
+    bool parse(std::string_view token, T &value, std::string &error) const
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            return detail::parseBool(token, value, error);
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            for (const auto &it : names_)
+            {
+                if (it.first == token)
+                {
+                    value = it.second;
+                    return true;
+                }
+            }
+            error = "expected one of " + value_name_;
+            return false;
+        }
+        else if constexpr (detail::IsDuration<T>::value)
+        {
+            return detail::parseDuration(token, value, error);
+        }
+        else
+        {
+            return detail::parseNumber(token, value, error);
+        }
+    }
+    std::string format(const T &value) const
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            return value ? "true" : "false";
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            for (const auto &it : names_)
+            {
+                if (it.second == value)
+                {
+                    return it.first;
+                }
+            }
+            return detail::formatNumber(static_cast<std::underlying_type_t<T>>(value));
+        }
+        else if constexpr (detail::IsDuration<T>::value)
+        {
+            return detail::formatDuration(value);
+        }
+        else
+        {
+            return detail::formatNumber(value);
+        }
+    }
+
+  protected:
+    void xparse(boost::any &value_store, const std::vector<std::string> &new_tokens) const override
+    {
+        namespace po = boost::program_options;
+        po::validators::check_first_occurrence(value_store);
+        if (new_tokens.empty() && !implicit_value_.empty())
+        {
+            value_store = implicit_value_;
+            return;
+        }
+        const std::string &token = po::validators::get_single_string(new_tokens);
+        T value{};
+        std::string error;
+        if (!parse(token, value, error))
+        {
+            throw InvalidValue(token, error);
+        }
+        value_store = value;
+    }
+
+  private:
+    T *store_;
+    names_t names_; // enums only
+    std::string value_name_;
+    boost::any default_value_;
+    std::string default_text_;
+    boost::any implicit_value_;
+    std::string implicit_text_;
+    std::function<void(const T &)> notifier_;
+    bool required_{false};
+};
+
+// Like po::value<T>(store), the result is owned by the option description
+template <class T> TypedValue<T> *typedValue(T *store = nullptr)
+{
+    static_assert(!std::is_enum_v<T>, "the names of the enum values are given to enumValue");
+    return new TypedValue<T>(store);
+}
+
+// The value is one of the names: enumValue(&mode, {{"fast", Mode::Fast}, {"safe", Mode::Safe}})
+template <class T> TypedValue<T> *enumValue(T *store, typename TypedValue<T>::names_t names)
+{
+    static_assert(std::is_enum_v<T>);
+    return new TypedValue<T>(store, std::move(names));
+}
+
+} /* namespace program_options_heavy */
+
+#endif // __TYPED_VALUE_H__
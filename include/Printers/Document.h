@@ -2,7 +2,11 @@
 #define __ABSTRACT_TEXT_SECTION__
 
 #include <memory>
-#include <sstream>
+#include <memory_resource>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace program_options_heavy
@@ -15,6 +19,7 @@ class AbstractItem;
 class Paragraph;
 class UnorderedList;
 class Section;
+class Document;
 
 class DocumentVisitor
 {
@@ -27,20 +32,92 @@ class DocumentVisitor
 
 class AbstractItem
 {
+    // The items are allocated in the arena of their Document and are never
+    // destroyed one by one, the whole arena is released with the document.
+    // Hence the items refer to each other by plain pointers. The text of the
+    // items is owned by the items, its strings allocate from the arena too.
   public:
+    AbstractItem(Document &document) : document{document}
+    {
+    }
     virtual void accept(DocumentVisitor &visitor) = 0;
+
+    Document &document;
 };
 
-class Paragraph : public AbstractItem
+class Document : public std::enable_shared_from_this<Document>
 {
+    // Owner of the help message: all the items and their text are allocated
+    // from a single monotonic arena
   public:
-    Paragraph()
+    static std::shared_ptr<Document> create()
+    {
+        return std::shared_ptr<Document>(new Document());
+    }
+    Document(const Document &) = delete;
+    Document &operator=(const Document &) = delete;
+
+    // The pointer keeps the whole document alive
+    template <class T> std::shared_ptr<T> share(T *item)
+    {
+        return std::shared_ptr<T>(shared_from_this(), item);
+    }
+    // Creates a new item in the arena
+    template <class T> T *make()
+    {
+        return new (arena_.allocate(sizeof(T), alignof(T))) T(*this);
+    }
+    std::pmr::memory_resource *resource()
+    {
+        return &arena_;
+    }
+
+    // Output stream writing into the arena, e.g. for operator<< of boost
+    // options_description
+    class Stream : private std::streambuf, public std::ostream
+    {
+      public:
+        Stream(Document &document) : std::ostream(this), text_{document.resource()}
+        {
+        }
+        std::string_view text() const
+        {
+            return text_;
+        }
+
+      private:
+        std::pmr::string text_;
+
+        std::streambuf::int_type overflow(std::streambuf::int_type ch) override
+        {
+            if (ch != std::char_traits<char>::eof())
+            {
+                text_ += static_cast<char>(ch);
+            }
+            return ch;
+        }
+        std::streamsize xsputn(const char *str, std::streamsize count) override
+        {
+            text_.append(str, static_cast<size_t>(count));
+            return count;
+        }
+    };
+
+  private:
+    Document() : arena_{initial_size}
     {
     }
-    Paragraph(const std::string &str) : text{str}
+    static constexpr size_t initial_size = 4096;
+    std::pmr::monotonic_buffer_resource arena_;
+};
+
+class Paragraph : public AbstractItem
+{
+  public:
+    Paragraph(Document &document) : AbstractItem(document), text{document.resource()}
     {
     }
-    std::string text;
+    std::pmr::string text;
     void accept(DocumentVisitor &visitor) override
     {
         visitor.visit(*this);
@@ -50,7 +127,14 @@ class Paragraph : public AbstractItem
 class UnorderedList : public AbstractItem
 {
   public:
-    std::vector<std::string> items;
+    UnorderedList(Document &document) : AbstractItem(document), items{document.resource()}
+    {
+    }
+    std::pmr::vector<std::pmr::string> items;
+    void add(std::string_view str)
+    {
+        items.emplace_back(str);
+    }
     void accept(DocumentVisitor &visitor) override
     {
         visitor.visit(*this);
@@ -60,11 +144,27 @@ class UnorderedList : public AbstractItem
 class Section : public AbstractItem
 {
   public:
-    std::string title;
-    std::vector<std::shared_ptr<AbstractItem>> items;
-    void add_paragraph(const std::string &str)
+    Section(Document &document) : AbstractItem(document), title{document.resource()}, items{document.resource()}
+    {
+    }
+    std::pmr::string title;
+    std::pmr::vector<AbstractItem *> items;
+
+    void setTitle(std::string_view str)
+    {
+        title = str;
+    }
+    Paragraph *add_paragraph(std::string_view str)
+    {
+        auto res = add<Paragraph>();
+        res->text = str;
+        return res;
+    }
+    template <class T> T *add()
     {
-        items.push_back(std::make_shared<Paragraph>(str));
+        T *res = document.make<T>();
+        items.push_back(res);
+        return res;
     }
     void accept(DocumentVisitor &visitor) override
     {
@@ -76,4 +176,4 @@ class Section : public AbstractItem
 
 } /* namespace program_options_heavy */
 
-#endif // __ABSTRACT_TEXT_SECTION__
\ No newline at end of file
+#endif // __ABSTRACT_TEXT_SECTION__
@@ -0,0 +1,126 @@
+#ifndef __OUTPUT_SINK_H__
+#define __OUTPUT_SINK_H__
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include <unistd.h>
+
+namespace program_options_heavy
+{
+
+namespace printers
+{
+
+class OutputSink
+{
+    // Destination of the rendered text. PrettyPrinter renders the whole
+    // document first and calls write() once.
+  public:
+    virtual ~OutputSink() = default;
+    virtual void write(std::string_view text) = 0;
+    // Escape sequences are written to terminals only (ColorMode::Auto)
+    virtual bool isTerminal() const
+    {
+        return false;
+    }
+};
+
+class FdSink : public OutputSink
+{
+  public:
+    FdSink(int fd = STDOUT_FILENO) : fd_{fd}
+    {
+    }
+    void write(std::string_view text) override
+    {
+        if (fd_ == STDOUT_FILENO || fd_ == STDERR_FILENO)
+        {
+            // keep the order with the output buffered by iostreams and stdio
+            std::cout.flush();
+            std::cerr.flush();
+            std::fflush(nullptr);
+        }
+        while (!text.empty())
+        {
+            ssize_t res = ::write(fd_, text.data(), text.size());
+            if (res < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+            text.remove_prefix(static_cast<size_t>(res));
+        }
+    }
+    bool isTerminal() const override
+    {
+        return isatty(fd_);
+    }
+
+  private:
+    int fd_;
+};
+
+class FileSink : public OutputSink
+{
+  public:
+    FileSink(FILE *file) : file_{file}
+    {
+    }
+    void write(std::string_view text) override
+    {
+        std::fwrite(text.data(), 1, text.size(), file_);
+        std::fflush(file_);
+    }
+    bool isTerminal() const override
+    {
+        return isatty(fileno(file_));
+    }
+
+  private:
+    FILE *file_;
+};
+
+class StringSink : public OutputSink
+{
+  public:
+    StringSink(std::string &str) : str_{str}
+    {
+    }
+    void write(std::string_view text) override
+    {
+        str_.append(text);
+    }
+
+  private:
+    std::string &str_;
+};
+
+class StreamSink : public OutputSink
+{
+  public:
+    StreamSink(std::ostream &stream) : stream_{stream}
+    {
+    }
+    void write(std::string_view text) override
+    {
+        stream_.write(text.data(), static_cast<std::streamsize>(text.size()));
+        stream_.flush();
+    }
+
+  private:
+    std::ostream &stream_;
+};
+
+} /* namespace printers */
+
+} /* namespace program_options_heavy */
+
+#endif // __OUTPUT_SINK_H__
@@ -2,13 +2,11 @@
 #define __PRETTY_PRINTER_H__
 
 #include <Printers/Document.h>
+#include <Printers/OutputSink.h>
 
-#include <iostream>
-#include <locale>
 #include <memory>
-#include <sstream>
 #include <string>
-#include <vector>
+#include <string_view>
 
 namespace program_options_heavy
 {
@@ -18,131 +16,93 @@ namespace printers
 
 class PrettyPrinter : public DocumentVisitor
 {
+    // Renders the document into a single buffer which is written to the sink
+    // at once, stdout by default
   public:
-    void visit(const AbstractItem &item) override
+    enum class ColorMode
     {
-        assert(false);
-    }
-    void visit(const Paragraph &item) override
+        Auto, // escape sequences are used if the sink is a terminal
+        Always,
+        Never
+    };
+
+    PrettyPrinter(ColorMode colors = ColorMode::Auto) : PrettyPrinter(std::make_shared<FdSink>(), colors)
     {
-        printText(level, item.text);
     }
-    void visit(const UnorderedList &lst) override
+    PrettyPrinter(std::shared_ptr<OutputSink> sink, ColorMode colors = ColorMode::Auto)
+        : sink_{std::move(sink)}, colors_{colors}
     {
-        for (const auto &item : lst.items)
-        {
-            printText(level, std::string("*") + item);
-        }
-    }
-    void visit(const Section &item) override
-    {
-        printTitle(level, item.title);
-        level++;
-        for (const auto &item : item.items)
-        {
-            item->accept(*this);
-        }
-        level--;
     }
 
-    void print(const std::shared_ptr<AbstractItem> item)
-    {
-        item->accept(*this);
-    }
+    void visit(const AbstractItem &item) override;
+    void visit(const Paragraph &item) override;
+    void visit(const UnorderedList &lst) override;
+    void visit(const Section &item) override;
+
+    void print(const std::shared_ptr<AbstractItem> item);
+    // The text is valid until the next call
+    std::string_view render(const std::shared_ptr<AbstractItem> item);
 
   private:
     size_t level{0};
+    std::shared_ptr<OutputSink> sink_;
+    ColorMode colors_;
+    bool use_escapes_{false};
+    std::string buffer_; // reused between the calls
+    bool rendering_{false};
 
-    static void printTitle(size_t level, const std::string &str)
-    {
-        if (str.empty())
-        {
-            return;
-        }
-        std::cout << "\n" << print(titleprefix(level), toUpper(str), titlesuffix(level)) << std::endl;
-    }
-    static void printText(size_t level, const std::string &str)
-    {
-        if (str.empty())
-        {
-            return;
-        }
-        std::cout << print(textprefix(level), str, textsuffix(level)) << std::endl;
-    }
-    static std::string print(const std::string &lineprefix, const std::string_view &view, const std::string &linesuffix)
+    // The item visited directly (item->accept(printer)) is written to the
+    // sink as soon as it is rendered
+    struct Rendering
     {
-        if (view.empty())
+        Rendering(PrettyPrinter &printer) : printer{printer}, top{!printer.rendering_}
         {
-            return "";
-        }
-        std::stringstream res;
-        res << lineprefix;
-        for (auto ch : view)
-        {
-            if (ch == '\n')
+            if (top)
             {
-                res << linesuffix << "\n";
-                res << lineprefix;
+                printer.begin();
             }
-            else
+        }
+        ~Rendering()
+        {
+            if (top)
             {
-                res << ch;
+                printer.rendering_ = false;
+                printer.sink_->write(printer.buffer_);
             }
         }
-        res << linesuffix;
-        return res.str();
-    }
-    static std::string titleprefix(size_t level)
-    {
-        if (level <= 1)
-        {
-            return repeat(level, "  ") + bold();
-        };
-        return repeat(level, "  ");
-    }
-    static std::string titlesuffix(size_t level)
-    {
-        return reset();
-    }
-    static std::string textprefix(size_t level)
-    {
-        return repeat(level + 1, "  ");
-    }
-    static std::string textsuffix(size_t level)
-    {
-        return "";
-    }
-    static std::string repeat(size_t level, std::string pattern = " ")
+        PrettyPrinter &printer;
+        bool top;
+    };
+    void begin();
+
+    void printTitle(size_t level, std::string_view str);
+    void printText(size_t level, std::string_view str, std::string_view bullet = {});
+    void indent(size_t level)
     {
-        std::string res;
-        for (size_t n = 0; n < level; n++)
-            res += pattern;
-        return res;
+        buffer_.append(2 * level, ' ');
     }
-    static std::string toUpper(const std::string_view &str)
+    void escape(std::string_view code)
     {
-        std::string res;
-        for (auto ch : str)
+        if (use_escapes_)
         {
-            res += std::toupper(ch);
+            buffer_ += code;
         }
-        return res;
     }
     // For esc-codes, see
     // https://man7.org/linux/man-pages/man4/console_codes.4.html
-    static std::string underline()
+    static constexpr std::string_view underline()
     {
         return "\033[4m";
     }
-    static std::string bold()
+    static constexpr std::string_view bold()
     {
         return "\033[1m";
     }
-    static std::string red()
+    static constexpr std::string_view red()
     {
         return "\033[31m";
     }
-    static std::string reset()
+    static constexpr std::string_view reset()
     {
         return "\033[0m";
     }
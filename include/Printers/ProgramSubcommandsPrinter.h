@@ -4,6 +4,13 @@
 #include <Parsers/ParserWithSubcommands.h>
 #include <Printers/PrettyPrinter.h>
 
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace program_options_heavy
 {
 
@@ -13,96 +20,41 @@ namespace printers
 class ProgramSubcommandsPrinter
 {
   public:
-    std::shared_ptr<Section> print(ParserWithSubcommands &parser)
+    std::shared_ptr<Section> print(ParserWithSubcommands &parser);
+    // The help for the single subcommand (prog help run, see
+    // HelpSubcommand::topic()): full details of the subcommand and one line
+    // for every other one. The path of a nested subcommand is given by the
+    // names separated by spaces ("cluster node drain"); the help of a branch
+    // lists its subcommands. The sections are cached per parser, so the
+    // repeated requests cost nothing; call clearCache() if the subcommands
+    // are changed or the parser is destroyed.
+    std::shared_ptr<Section> print(ParserWithSubcommands &parser, std::string_view subcommand_path);
+    void clearCache()
     {
-        auto res = std::make_shared<Section>();
-        auto usage = std::make_shared<Section>();
-        usage->title = "Usage:";
-        for (auto &subcmd : parser.subcommandsOrder())
-        {
-            usage->add_paragraph("\t" + shortHelp(parser, subcmd));
-        }
+        cache_.clear();
+    }
+    std::string shortHelp(ParserWithSubcommands &parser, const ParserWithSubcommands::Subcommand &subcmd) const;
+    std::string subcommandDescription(ParserWithSubcommands &parser,
+                                      const ParserWithSubcommands::Subcommand &subcmd) const;
+    // Adds the sections of the groups not printed yet to parent
+    void print(Parser &parser, Section &parent);
+    Section *print(OptionsGroup &grp, Section &parent) const;
 
-        auto description = std::make_shared<Section>();
-        description->title = "Description:";
-        description->add_paragraph(parser.program_description);
-        for (auto &subcmd : parser.subcommandsOrder())
-        {
-            description->add_paragraph("\t" + subcommandDescription(parser, subcmd));
-        }
+    // The overloads of the earlier versions, the sections are in their own
+    // documents
+    std::vector<std::shared_ptr<Section>> print(Parser &parser);
+    std::shared_ptr<Section> print(OptionsGroup &grp) const;
+    [[deprecated("use shortHelp(parser, parser.subcommand(name))")]] std::string shortHelp(
+        ParserWithSubcommands &parser, ParserWithSubcommands::subcommands_t::iterator it) const;
+    [[deprecated("use subcommandDescription(parser, parser.subcommand(name))")]] std::string subcommandDescription(
+        ParserWithSubcommands &parser, ParserWithSubcommands::subcommands_t::iterator it) const;
+    std::set<std::string> options_groups_printed_already_;
 
-        auto details = std::make_shared<Section>();
-        details->title = "Details:";
-        for (auto &subcmd : parser.subcommandsOrder())
-        {
-            auto ptr = subcmd->second;
-            for (auto &it : print(*ptr))
-            {
-                details->items.push_back(it);
-            }
-        }
+  private:
+    // by the parsers and the subcommand paths
+    std::map<const ParserWithSubcommands *, std::map<std::string, std::shared_ptr<Section>, std::less<>>> cache_;
 
-        res->items.push_back(usage);
-        res->items.push_back(description);
-        res->items.push_back(details);
-        return res;
-    }
-    std::string shortHelp(ParserWithSubcommands &parser, ParserWithSubcommands::subcommands_t::iterator it) const
-    {
-        std::stringstream str;
-        str << parser.exename << " ";
-        if (it->first == parser.defaultSubcommandName())
-        {
-            if (!parser.hideDefaultSubcommandName())
-            {
-                str << "[" << it->first << "] ";
-            }
-        }
-        else
-        {
-            str << it->first << " ";
-        }
-        const std::shared_ptr<Parser> opts = it->second;
-        for (auto group : opts->groups())
-        {
-            str << "[" << group->groupName() << "] ";
-        }
-        return str.str();
-    }
-    std::string subcommandDescription(ParserWithSubcommands &parser, ParserWithSubcommands::subcommands_t::iterator it) const
-    {
-        std::stringstream str;
-        if (it->first != parser.defaultSubcommandName() || !parser.hideDefaultSubcommandName())
-        {
-            str << it->first << " - ";
-        }
-        str << it->second->program_description;
-        return str.str();
-    }
-    std::vector<std::shared_ptr<Section>> print(Parser &parser)
-    {
-        std::vector<std::shared_ptr<Section>> res;
-        for (auto it : parser.groups())
-        {
-            if (!options_groups_printed_already_.contains(it->groupName()))
-            {
-                res.push_back(print(*it));
-                options_groups_printed_already_.insert(it->groupName());
-            }
-        }
-        return res;
-    }
-    std::shared_ptr<Section> print(OptionsGroup &grp) const
-    {
-        auto res = std::make_shared<Section>();
-        res->title = grp.groupName();
-        res->add_paragraph(grp.description.str());
-        std::stringstream options_list;
-        options_list << grp.visible;
-        res->add_paragraph(options_list.str());
-        return res;
-    }
-    std::set<std::string> options_groups_printed_already_;
+    std::shared_ptr<Section> printSubcommand(ParserWithSubcommands &parser, std::string_view subcommand_name);
 };
 
 } /* namespace printers */
@@ -2,10 +2,19 @@
 #define __PROGRAM_OPTIONS_H__
 #include <Parsers/AbstractOptionsParser.h>
 #include <Parsers/BasicOptions.h>
+#include <Parsers/BatchRunner.h>
+#include <Parsers/ConfigSources.h>
 #include <Parsers/HelpSubcommand.h>
+#include <Parsers/HotReload.h>
+#include <Parsers/ListValue.h>
 #include <Parsers/OptionsGroup.h>
+#include <Parsers/ParseStats.h>
 #include <Parsers/Parser.h>
 #include <Parsers/ParserWithSubcommands.h>
+#include <Parsers/ResponseFile.h>
+#include <Parsers/StaticParser.h>
+#include <Parsers/Suggestions.h>
+#include <Parsers/TypedValue.h>
 #include <Printers/PrettyPrinter.h>
 #include <Printers/ProgramOptionsPrinter.h>
 #include <Printers/ProgramSubcommandsPrinter.h>
@@ -1,14 +1,23 @@
 #ifndef __COMPLETER_H__
 #define __COMPLETER_H__
 
+#include <Completion/CompletionCache.h>
+#include <Completion/CompletionIndex.h>
+#include <Completion/CompletionServer.h>
+#include <Completion/ValueCompleter.h>
 #include <Parsers/ParserWithSubcommands.h>
 
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
 #include <string>
 #include <optional>
+#include <span>
+#include <tuple>
 #include <vector>
 #include <string_view>
-#include <ranges>
-#include <cstdlib>
 
 namespace program_options_heavy {
 
@@ -20,223 +29,120 @@ inline std::vector<std::string> getCompletionVariants(const std::string &program
 
 
 class Completer {
-    /// TODOLIST:
-    /// 1. Process the values passed for options
-    /// 2. Take into account that any option can have different names
     public:
-        Completer(std::shared_ptr<ParserWithSubcommands>& parser) : parser_{parser} {
-            all_variants_ = getAllVariants();
-            for(const auto& it : all_variants_)
-                all_command_names.push_back(it.first);
+        Completer(std::shared_ptr<ParserWithSubcommands>& parser);
+        Completer(completion::CompletionIndex index) : index_{std::move(index)} {
         }
 
-        std::vector<std::string> getCompletionVariants() {            
-            auto completion_line = getLineForCompletion();
-            if(completion_line.has_value())
-                return getCompletionVariants(completion_line.value());
-            return {};
+        // Answers COMP_LINE from the on-disk cache without constructing any
+        // parser. Call it at the very beginning of main(). Returns nullopt if
+        // COMP_LINE is not set or the cache is missing or stale, in this case
+        // build the parser as usual and refresh the cache with saveCache().
+        // The value completers are not stored in the cache: if the schema has
+        // them and the word under the cursor may be a value, nullopt is
+        // returned too and the full completer has to answer.
+        static std::optional<std::vector<std::string>> completeFromCache(
+            const completion::CompletionCache& cache = completion::CompletionCache(), uint64_t schema_hash = 0);
+
+        // Asks the completion server started by spawnServer() to complete
+        // COMP_LINE. Returns nullopt if COMP_LINE is not set, there is no
+        // server or the server is stale. Pass schema_hash (see
+        // CompletionIndex::hash) to be sure that the server has the same
+        // schema, otherwise the server checks that its executable was not
+        // rebuilt.
+        static std::optional<std::vector<std::string>> completeFromServer(
+            std::optional<uint64_t> schema_hash = std::nullopt,
+            const std::filesystem::path& socket_path = completion::CompletionProtocol::defaultSocketPath());
+
+        // Starts the completion server in the background process, the server
+        // keeps the index in memory and answers over the per-user Unix
+        // domain socket until idle_timeout expires. Returns false if fork
+        // failed.
+        bool spawnServer(std::chrono::milliseconds idle_timeout = std::chrono::minutes(10),
+                         const std::filesystem::path& socket_path = completion::CompletionProtocol::defaultSocketPath());
+
+        const completion::CompletionIndex& index() const {
+            return index_;
         }
 
-        std::vector<std::string> getCompletionVariants(const std::string& completion_line) {
-            auto words = split(completion_line);
-            return getCompletionVariants(words);
-        }
-
-    private:
-        std::shared_ptr<ParserWithSubcommands> parser_;
+        bool saveCache(const completion::CompletionCache& cache = completion::CompletionCache(), uint64_t schema_hash = 0);
 
-        struct Command {
-            std::string name;
-            std::vector<std::vector<std::string>> options;
-            std::vector<std::string> canonical_options; // same size as options
-        };        
-        std::map<std::string, Command> all_variants_;
-        std::vector<std::string> all_command_names;
-
-        struct MatchResults {
-            std::optional<std::size_t> whole_match_idx;
-            std::vector<std::string> variants;
-            std::vector<std::size_t> variants_idx;
-        };
-
-        MatchResults getCompletionVariants(const std::string_view& word, const std::vector<std::string>& variants) {
-            MatchResults res;
-            for(size_t n = 0; n < variants.size(); n++) {
-                if(variants[n].find(word) == 0) {
-                    res.variants.push_back(variants[n]);
-                    res.variants_idx.push_back(n);
-                    if(variants[n] == word) {
-                        res.whole_match_idx = n;
-                    }
-                }
-            }
-            return res;
-        }
+        std::vector<std::string> getCompletionVariants();
 
-        MatchResults getCompletionVariants(const std::string_view& word, const std::vector<std::vector<std::string>>& variants) {
-            MatchResults res;
-            for(size_t n = 0; n < variants.size(); n++) {
-                MatchResults tmp = getCompletionVariants(word, variants[n]);                
-                if(tmp.variants.size() > 0) {
-                    res.variants.push_back(tmp.variants.front());
-                    res.variants_idx.push_back(n);
-                }
-                if(tmp.whole_match_idx.has_value()) {
-                    res.whole_match_idx = n;
-                }
-            }
-            return res;
-        }
+        std::vector<std::string> getCompletionVariants(const std::string& completion_line);
 
-        std::tuple<std::string_view, std::string_view, std::vector<std::string_view>> byRoles(const std::vector<std::string_view>& words) {
-            std::string_view exec_name;
-            std::string_view command_name;
-            std::vector<std::string_view> options;
-            size_t processed = 0;
-            if(!parser_->exename.empty() && words.size() > 0) {
-                exec_name = words[0];
-                processed++;
-            }
-            if(words.size() > processed && words[processed].find('-') != 0) {
-                command_name = words[processed];
-                processed++;
-            }
-            for(size_t n = processed; n < words.size(); n++) {
-                options.push_back(words[n]);
-            }
-            return {exec_name, command_name, options};
+        // The hard limit on the number of completions of a value, see
+        // OptionsGroup::setValueCompleter
+        void setMaxValueCandidates(size_t max_count) {
+            max_value_candidates_ = max_count;
         }
 
-        std::vector<std::string> getCompletionVariants(const std::vector<std::string_view>& words) {
-            auto [exec_name, command_name, options] = byRoles(words);
-
-            // match the name of the executable
-            std::vector<std::string> exe_variants{parser_->exename};
-            if(!parser_->exename.empty()) {                                
-                MatchResults exe_match_results = getCompletionVariants(exec_name, exe_variants);
-                if(exe_match_results.whole_match_idx.has_value() == false)
-                    return exe_match_results.variants;
-            }            
-
-            // match the name of the command
-            MatchResults command_match_results = getCompletionVariants(command_name, all_command_names);
-            if(command_match_results.whole_match_idx.has_value() == false)
-                return command_match_results.variants;
-            
-            const std::string& subcommand = all_command_names[command_match_results.whole_match_idx.value()];
-
-            std::vector<std::vector<std::string>> rest_options = all_variants_[subcommand].options;
-            std::vector<std::string> canonical_rest_options = all_variants_[subcommand].canonical_options;
-            // match command options
-            if(options.size() > 0) {
-                bool last_option_full_match = false;
-
-                // remove all used options
-                std::vector<size_t> remove_idx;
-                for(size_t idx = 0; idx < options.size(); idx++) {
-                    MatchResults match_results = getCompletionVariants(options[idx], rest_options);
-                    if(match_results.whole_match_idx.has_value()) {
-                        size_t rest_idx = match_results.whole_match_idx.value();
-                        remove_idx.push_back(rest_idx);
-                        if(idx + 1 == options.size()) {
-                            last_option_full_match = true;
-                        }
-                    };
-                }
-                for(auto it = remove_idx.rbegin(); it != remove_idx.rend(); it++) {
-                    rest_options.erase(rest_options.begin() + *it);
-                    canonical_rest_options.erase(canonical_rest_options.begin() + *it);
-                }
-                // last option should be processed separately
-                if(!last_option_full_match) {
-                    const std::string_view& last_option = options.back();
-                    MatchResults match_results = getCompletionVariants(last_option, rest_options);
-                    return match_results.variants;
-                }
-            }
-            return canonical_rest_options;
-        }
-
-        std::map<std::string, Command> getAllVariants() {
-            std::map<std::string, Command> res;
-            for(auto it : parser_->getSubcommands()) {
-                std::shared_ptr<Parser> parser = it.second;
-                Command cmd;
-                cmd.name = it.first;
-                for(auto grp : parser->groups()) {
-                    for(auto opt: grp->visible.options()) {
-                        auto& oopt = *opt;
-                        cmd.options.push_back(getOptionNames(oopt));
-                        cmd.canonical_options.push_back(getCanonicalName(oopt));
-                    }
-                }
-                res[cmd.name] = std::move(cmd);
-
-            }
-            return res;
-        }
-
-
-        std::string getCanonicalName(const boost::program_options::option_description& opt) {
-            const std::vector<std::string>& all_names = getOptionNames(opt);
-            assert(!all_names.empty());
-            return all_names.front();
-        }
-        std::vector<std::string> getOptionNames(const boost::program_options::option_description& opt) {
-            /// \todo: move to OptionsGroup
-            std::vector<std::string> res;
-            const std::pair<const std::string*, size_t> long_names = opt.long_names();
-            for(size_t n = 0; n < long_names.second; n++) {
-                std::string str = std::string("--") + *(long_names.first + n);
-                res.push_back(str);
-            }
-            //extract short name:
-            std::string short_name = opt.canonical_display_name(boost::program_options::command_line_style::allow_dash_for_short);
-            if(!short_name.empty()) {
-                if(short_name.size() == 1) {
-                    short_name = std::string("-") + short_name;
-                }
-                res.push_back(short_name);
-            } else {
-                res.push_back("empty");
-            }
-            return res;
-        }
-
-        std::string_view trim(std::string_view str) {
-            size_t trim_from_start = str.find_first_not_of(' ');
-            size_t trim_from_end = str.find_last_not_of(' ');
-            if(trim_from_start != std::string_view::npos) {
-                assert(trim_from_end != std::string_view::npos);
-                size_t len = trim_from_end - trim_from_start + 1;
-                return str.substr(trim_from_start, len);
-            }
-            return str.substr(0, 0); //empty string view
-        }
-
-        std::vector<std::string_view> split(std::string_view line) {
-            std::vector<std::string_view> res;            
-            size_t start = 0;
-            size_t finish;            
-            do {
-                finish = line.find(' ', start+1);
-                auto substr = line.substr(start, finish - start);
-                substr = trim(substr);
-                if(substr.length() > 0) {
-                    res.push_back(substr);
-                }
-                start = finish + 1;
-            } while(finish != std::string::npos);
-            return res;
-        }
-
-        std::optional<std::string> getLineForCompletion() {
-            if(const char* cstr = getenv("COMP_LINE")) {
-                return std::string(cstr);
-            } else {
-                return std::nullopt;
-            }
-        }
+    private:
+        std::shared_ptr<ParserWithSubcommands> parser_;
+        std::map<uint32_t, std::optional<completion::CompletionIndex>> lazy_; // lazy subcommands by their numbers in index_
+        // completers of the branches (see ParserWithSubcommands::addBranch) by
+        // their numbers in index_, nullptr until the branch is completed
+        std::map<uint32_t, std::shared_ptr<Completer>> branches_;
+        // value completers by the command names and the option numbers,
+        // nullptr for the options without completers (filled by buildIndex)
+        std::map<std::string, std::vector<std::shared_ptr<const completion::ValueCompleter>>, std::less<>>
+                value_completers_;
+        size_t max_value_candidates_{256};
+        completion::CompletionIndex index_;
+        bool values_omitted_{false}; // the index is loaded from the cache of the schema with value completers
+        bool needs_parser_{false};   // set by the completion which the cache can't answer
+
+        // "--opt val" or "--opt=val" under the cursor, the options taking no
+        // value are not known without the parser
+        static bool mayBeValue(const std::vector<std::string_view>& options);
+
+        // The words of a nested level are split with with_exename = false
+        std::tuple<std::string_view, std::string_view, std::vector<std::string_view>> byRoles(
+                const std::vector<std::string_view>& words, bool with_exename = true);
+
+        std::vector<std::string> getCompletionVariants(const std::vector<std::string_view>& words);
+
+        // Completes the words after the name of the executable, the words
+        // after the name of a branch are completed by the completer of the
+        // branch, so only the taken path of the tree is indexed. The index
+        // loaded from the cache has all the levels, there the commands of
+        // the nested level are named by the path of the branch given in
+        // level ("cluster node ").
+        std::vector<std::string> completeCommand(std::string_view command_name,
+                const std::vector<std::string_view>& options, const std::string& level = "");
+
+        // Completes the value if the word under the cursor is the value of an
+        // option with the value completer: "--opt val" or "--opt=val"
+        std::optional<std::vector<std::string>> completeValue(std::string_view command_name,
+                const completion::CompletionIndex& options_index, uint32_t command,
+                const std::vector<std::string_view>& options);
+
+        // Lazy subcommands (see ParserWithSubcommands::addLazy) are indexed by
+        // name only
+        completion::CompletionIndex buildIndex();
+
+        // The index saved to the cache, which is used without the parser: the
+        // lazy subcommands are instantiated, the commands of the branches are
+        // added under their paths ("cluster node drain")
+        completion::CompletionIndex buildCacheIndex(bool& has_value_completers);
+        static void addCommands(completion::CompletionIndex& index, ParserWithSubcommands& parser,
+                const std::string& level, bool& has_value_completers);
+
+        // The names of the options of all the groups, viewed in OptionsGroup::schema()
+        static std::vector<std::span<const std::string_view>> optionNames(Parser& parser, bool& has_value_completers);
+        // optionNames() which also keeps the value completers of the command
+        std::vector<std::span<const std::string_view>> getOptions(const std::string& command_name, Parser& parser);
+
+        // The index with the options of the command. The options of a lazy
+        // subcommand are indexed when it is completed for the first time, in
+        // this case command is replaced by its number in the returned index.
+        const completion::CompletionIndex& optionsIndex(uint32_t& command);
+
+        std::string_view trim(std::string_view str);
+
+        std::vector<std::string_view> split(std::string_view line);
+
+        static std::optional<std::string> getLineForCompletion();
 
 };
 
@@ -0,0 +1,81 @@
+#include <Parsers/ListValue.h>
+
+#include <bit>
+#include <cstring>
+
+namespace program_options_heavy
+{
+
+namespace detail
+{
+
+namespace
+{
+
+// SWAR (SIMD within a register) kernels: 8 ASCII characters loaded into one
+// little endian 64-bit word are checked and converted with a few integer
+// operations instead of 8 iterations
+bool isEightDigits(uint64_t chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+           0x3333333333333333;
+}
+
+uint32_t parseEightDigits(uint64_t chunk)
+{
+    constexpr uint64_t mask = 0x000000FF000000FF;
+    constexpr uint64_t mul1 = 100 + (1000000ULL << 32);
+    constexpr uint64_t mul2 = 1 + (10000ULL << 32);
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10) + (chunk >> 8); // pairs of digits
+    return static_cast<uint32_t>((((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32);
+}
+
+} // namespace
+
+bool parseDigits(const char *&p, const char *end, uint64_t &value, size_t &digits)
+{
+    value = 0;
+    digits = 0;
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        // 19 digits always fit into uint64_t
+        while (end - p >= 8 && digits + 8 <= 19)
+        {
+            uint64_t chunk;
+            std::memcpy(&chunk, p, sizeof(chunk));
+            if (!isEightDigits(chunk))
+            {
+                break;
+            }
+            value = value * 100000000 + parseEightDigits(chunk);
+            p += 8;
+            digits += 8;
+        }
+    }
+    constexpr uint64_t max = std::numeric_limits<uint64_t>::max();
+    for (; p != end && *p >= '0' && *p <= '9'; p++, digits++)
+    {
+        uint64_t digit = static_cast<uint64_t>(*p - '0');
+        if (value > (max - digit) / 10)
+        {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+std::string shortToken(std::string_view token)
+{
+    constexpr size_t max_length = 64;
+    if (token.size() <= max_length)
+    {
+        return std::string(token);
+    }
+    return std::string(token.substr(0, max_length)) + "...";
+}
+
+} /* namespace detail */
+
+} /* namespace program_options_heavy */
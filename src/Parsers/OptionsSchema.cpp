@@ -0,0 +1,71 @@
+#include <Parsers/OptionsSchema.h>
+
+#include <boost/program_options/cmdline.hpp>
+
+#include <cstddef>
+#include <utility>
+
+namespace program_options_heavy
+{
+
+OptionsSchema::OptionsSchema(
+    const boost::program_options::options_description &visible,
+    const std::map<std::string, std::shared_ptr<completion::ValueCompleter>> &value_completers)
+{
+    namespace po = boost::program_options;
+    // the views are made after the pool stops growing, till then the names
+    // are kept as the offsets
+    std::vector<std::pair<size_t, size_t>> names;
+    std::vector<size_t> first_name;
+    std::vector<std::pair<size_t, size_t>> descriptions;
+    auto intern = [this](std::string_view prefix, std::string_view str) {
+        std::pair<size_t, size_t> res{pool_.size(), prefix.size() + str.size()};
+        pool_ += prefix;
+        pool_ += str;
+        return res;
+    };
+    for (const auto &opt : visible.options())
+    {
+        first_name.push_back(names.size());
+        auto long_names = opt->long_names();
+        for (size_t n = 0; n < long_names.second; n++)
+        {
+            names.push_back(intern("--", long_names.first[n]));
+        }
+        // "-s" if the option has the short name
+        std::string short_name = opt->canonical_display_name(po::command_line_style::allow_dash_for_short);
+        if (short_name.size() == 2 && short_name[0] == '-')
+        {
+            names.push_back(intern("", short_name));
+        }
+        descriptions.push_back(intern("", opt->description()));
+    }
+    first_name.push_back(names.size());
+
+    names_.reserve(names.size());
+    for (const auto &it : names)
+    {
+        names_.push_back(std::string_view(pool_).substr(it.first, it.second));
+    }
+    std::span<const std::string_view> all_names(names_);
+    options_.reserve(visible.options().size());
+    for (size_t n = 0; n < visible.options().size(); n++)
+    {
+        Option option{};
+        option.names = all_names.subspan(first_name[n], first_name[n + 1] - first_name[n]);
+        if (!option.names.empty() && option.names.front().starts_with("--"))
+        {
+            option.long_name = option.names.front().substr(2);
+        }
+        option.description = std::string_view(pool_).substr(descriptions[n].first, descriptions[n].second);
+        auto completer = value_completers.find(visible.options()[n]->long_name());
+        if (completer != value_completers.end() && completer->second)
+        {
+            option.completer = completer->second;
+            has_value_completers_ = true;
+        }
+        options_.push_back(option);
+    }
+}
+
+} /* namespace program_options_heavy */
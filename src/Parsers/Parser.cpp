@@ -0,0 +1,606 @@
+#include <Parsers/Parser.h>
+
+#include <Parsers/NameIndex.h>
+#include <Parsers/Suggestions.h>
+
+#include <boost/program_options/parsers.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+namespace detail
+{
+
+// Options of all the groups of the Parser, built on the first parse
+struct MergedDescription
+{
+    boost::program_options::options_description partial;
+    boost::program_options::positional_options_description positional;
+    size_t options_count{0};
+    // exact names lookup index
+    std::vector<std::pair<std::string, boost::shared_ptr<boost::program_options::option_description>>> long_names;
+    NameIndex long_index;
+    std::array<boost::shared_ptr<boost::program_options::option_description>, 256> short_names;
+    std::shared_ptr<PositionalSink> sink; // see OptionsGroup::addPositionalSink
+    const boost::program_options::option_description *sink_option{nullptr};
+
+    const boost::shared_ptr<boost::program_options::option_description> *findLong(std::string_view name) const
+    {
+        auto pos = long_index.find(name, [this](uint32_t n) -> std::string_view { return long_names[n].first; });
+        return pos.has_value() ? &long_names[pos.value()].second : nullptr;
+    }
+};
+
+} /* namespace detail */
+
+namespace
+{
+
+using detail::MergedDescription;
+
+// The option found in the command line, the views point to the memory of
+// argv or of the response files
+struct Match
+{
+    const boost::program_options::option_description *option;
+    std::string_view token; // empty for positional arguments
+    std::string_view value;
+    bool has_value;
+    int position; // -1 for named options
+};
+
+// Collects the options referred by the command line. Returns false if
+// some token is not an exact name of an option (abbreviation, typo, value
+// starting with '-', etc.), in this case all the options should be used.
+bool selectUsedOptions(const MergedDescription &merged, const std::vector<std::string_view> &args,
+                       boost::program_options::options_description &used)
+{
+    std::set<const boost::program_options::option_description *> added;
+    auto add = [&](const boost::shared_ptr<boost::program_options::option_description> &opt) {
+        if (added.insert(opt.get()).second)
+        {
+            used.add(opt);
+        }
+    };
+    unsigned positional_count = std::min<size_t>(merged.positional.max_total_count(), args.size());
+    for (unsigned n = 0; n < positional_count; n++)
+    {
+        auto opt = merged.findLong(merged.positional.name_for_position(n));
+        if (!opt)
+        {
+            return false;
+        }
+        add(*opt);
+    }
+    for (std::string_view token : args)
+    {
+        if (token == "--")
+        {
+            break;
+        }
+        if (token.size() < 2 || token[0] != '-')
+        {
+            continue;
+        }
+        if (token[1] == '-')
+        {
+            token.remove_prefix(2);
+            auto opt = merged.findLong(token.substr(0, token.find('=')));
+            if (!opt)
+            {
+                return false;
+            }
+            add(*opt);
+            continue;
+        }
+        // sticky short options: -zxc or -d10
+        for (size_t ch = 1; ch < token.size(); ch++)
+        {
+            const auto &opt = merged.short_names[static_cast<unsigned char>(token[ch])];
+            if (!opt)
+            {
+                return false;
+            }
+            add(opt);
+            if (opt->semantic()->max_tokens() > 0)
+            {
+                break; // the rest of the token is the value
+            }
+        }
+    }
+    return true;
+}
+
+// Number of the options of the group given explicitly (not defaulted)
+size_t matchedCount(const OptionsGroup &group, const boost::program_options::variables_map &vm)
+{
+    size_t res = 0;
+    for (const auto &opt : group.partial.options())
+    {
+        auto it = vm.find(opt->key(std::string()));
+        if (it != vm.end() && !it->second.defaulted())
+        {
+            res++;
+        }
+    }
+    return res;
+}
+std::vector<std::string> suggestOptions(const MergedDescription &merged, std::string_view name)
+{
+    name = name.substr(std::min(name.find_first_not_of('-'), name.size()));
+    name = name.substr(0, name.find('='));
+    std::vector<std::string_view> names;
+    names.reserve(merged.long_names.size());
+    for (const auto &it : merged.long_names)
+    {
+        names.push_back(it.first);
+    }
+    return suggestions(name, names);
+}
+bool takesValue(const boost::program_options::option_description &opt)
+{
+    return opt.semantic()->max_tokens() > 0;
+}
+// Only switches and the options with exactly one value are matched here,
+// multitoken and implicit values are left to boost
+bool isSimple(const boost::program_options::option_description &opt)
+{
+    return opt.semantic()->max_tokens() == 0 ||
+           (opt.semantic()->min_tokens() == 1 && opt.semantic()->max_tokens() == 1);
+}
+bool isOptionLike(std::string_view token)
+{
+    return token.size() > 1 && token[0] == '-';
+}
+// Pushes the value to the positional sink at once, so the consumers of the
+// sink work while the rest of the command line is tokenized. The values from
+// "-" on are deferred until the options are stored: reading the input
+// depends on --null, and the order of the values is kept.
+void stream(const MergedDescription &merged, std::string_view value, std::vector<std::string_view> &deferred)
+{
+    if (deferred.empty() && value != "-")
+    {
+        merged.sink->push(value);
+    }
+    else
+    {
+        deferred.push_back(value);
+    }
+}
+// Splits the command line into views of argv without copying anything, the
+// values of the positional sink are streamed as soon as they are matched
+// and counted in streamed. Returns false if some token is not matched
+// exactly (abbreviation, unknown option, missing value, value starting with
+// '-', multitoken option, etc.), in this case the command line is parsed by
+// boost, which also reports the errors.
+bool tokenize(const MergedDescription &merged, const std::vector<std::string_view> &args, std::vector<Match> &matches,
+              std::vector<std::string_view> &deferred, size_t &streamed)
+{
+    unsigned position = 0;
+    auto addPositional = [&](std::string_view token) {
+        if (position >= merged.positional.max_total_count())
+        {
+            return false;
+        }
+        auto opt = merged.findLong(merged.positional.name_for_position(position));
+        if (!opt)
+        {
+            return false;
+        }
+        if (opt->get() == merged.sink_option)
+        {
+            stream(merged, token, deferred);
+            streamed++;
+            position++;
+            return true;
+        }
+        matches.push_back({opt->get(), {}, token, true, static_cast<int>(position++)});
+        return true;
+    };
+    bool only_positional = false;
+    for (size_t n = 0; n < args.size(); n++)
+    {
+        std::string_view token = args[n];
+        if (only_positional || !isOptionLike(token))
+        {
+            if (!addPositional(token))
+            {
+                return false;
+            }
+            continue;
+        }
+        if (token == "--")
+        {
+            only_positional = true;
+            continue;
+        }
+        if (token[1] == '-')
+        {
+            // --name, --name=value, --name value
+            std::string_view name = token.substr(2);
+            size_t eq = name.find('=');
+            auto opt = merged.findLong(name.substr(0, eq));
+            if (!opt || !isSimple(**opt))
+            {
+                return false;
+            }
+            Match match{opt->get(), token, {}, false, -1};
+            if (eq != std::string_view::npos)
+            {
+                match.value = name.substr(eq + 1);
+                match.has_value = true;
+                if (!takesValue(**opt) || match.value.empty())
+                {
+                    return false;
+                }
+            }
+            else if (takesValue(**opt))
+            {
+                if (n + 1 >= args.size() || isOptionLike(args[n + 1]))
+                {
+                    return false;
+                }
+                match.value = args[++n];
+                match.has_value = true;
+            }
+            matches.push_back(match);
+            continue;
+        }
+        // -zxc, -d10, -d 10
+        for (size_t ch = 1; ch < token.size(); ch++)
+        {
+            const auto &opt = merged.short_names[static_cast<unsigned char>(token[ch])];
+            if (!opt || !isSimple(*opt))
+            {
+                return false;
+            }
+            Match match{opt.get(), token, {}, false, -1};
+            if (takesValue(*opt))
+            {
+                if (ch + 1 < token.size())
+                {
+                    match.value = token.substr(ch + 1);
+                    if (match.value[0] == '=')
+                    {
+                        return false;
+                    }
+                }
+                else if (n + 1 < args.size() && !isOptionLike(args[n + 1]))
+                {
+                    match.value = args[++n];
+                }
+                else
+                {
+                    return false;
+                }
+                match.has_value = true;
+                matches.push_back(match);
+                break;
+            }
+            matches.push_back(match);
+        }
+    }
+    return true;
+}
+// The values are copied here, once the whole command line is matched. The
+// values for the positional sink are streamed by tokenize() and not copied.
+boost::program_options::parsed_options parsedOptions(const MergedDescription &merged, const std::vector<Match> &matches)
+{
+    namespace po = boost::program_options;
+    po::parsed_options res(&merged.partial, po::command_line_style::allow_long);
+    res.options.reserve(matches.size());
+    for (const auto &it : matches)
+    {
+        po::option &opt = res.options.emplace_back();
+        if (it.position >= 0)
+        {
+            opt.string_key = merged.positional.name_for_position(it.position);
+            opt.position_key = it.position;
+        }
+        else
+        {
+            opt.string_key = it.option->key(std::string());
+            opt.original_tokens.emplace_back(it.token); // for error messages
+        }
+        if (it.has_value)
+        {
+            opt.value.emplace_back(it.value);
+        }
+    }
+    return res;
+}
+
+} // namespace
+
+void Parser::addGroup(std::shared_ptr<OptionsGroup> options)
+{
+    if (options->positional.max_total_count() != 0)
+    {
+        for (auto it : groups_)
+        {
+            // only one group of options is allowed to have positional
+            // arguments
+            assert(it->positional.max_total_count() == 0);
+        }
+    }
+    groups_.push_back(options);
+    merged_.reset();
+}
+
+bool Parser::parse(int argc, const char *argv[])
+{
+    namespace po = boost::program_options;
+    using Phase = ParseStats::Phase;
+    ParseStats *stats = parse_stats_.get();
+    ParseStats::Scope parse_scope(stats, Phase::Parse, exename);
+    const MergedDescription &merged = [this, stats]() -> const MergedDescription & {
+        ParseStats::Scope scope(stats, Phase::MergeDescription, exename);
+        return mergedDescription();
+    }();
+    boost::program_options::variables_map vm;
+    std::vector<std::string_view> args(argv + std::min(argc, 1), argv + argc);
+    std::optional<ResponseFileExpander> expander; // owns the memory of the expanded args
+    if (response_files_.has_value() && std::any_of(args.begin(), args.end(), ResponseFileExpander::isResponseFile))
+    {
+        ParseStats::Scope scope(stats, Phase::ResponseFiles, exename);
+        args = expander.emplace(response_files_.value()).expand(args);
+    }
+    // the sink is closed in any case so that its consumers finish
+    auto close = [](PositionalSink *sink) {
+        if (sink)
+        {
+            sink->close();
+        }
+    };
+    if (merged.sink)
+    {
+        merged.sink->open();
+    }
+    std::unique_ptr<PositionalSink, void (*)(PositionalSink *)> sink_guard(merged.sink.get(), close);
+    std::vector<Match> matches;
+    std::vector<std::string_view> deferred; // values for the positional sink, see stream()
+    size_t streamed = 0;                    // values for the positional sink handled by tokenize()
+    std::vector<po::option> streamed_options;
+    try
+    {
+        bool tokenized;
+        {
+            ParseStats::Scope scope(stats, Phase::Tokenize, exename);
+            tokenized = tokenize(merged, args, matches, deferred, streamed);
+            scope.setOptionsMatched(matches.size());
+        }
+        if (tokenized)
+        {
+            ParseStats::Scope scope(stats, Phase::Store, exename);
+            scope.setOptionsMatched(matches.size());
+            po::store(parsedOptions(merged, matches), vm);
+        }
+        else
+        {
+            // boost matches every token against every option, so the command
+            // line is parsed with the options it refers to only. The defaults
+            // and the required options are still processed by store() with
+            // all options. Boost needs the copy of the command line, so the
+            // sink values are copied here and the ones not streamed by
+            // tokenize() are pushed once the whole command line is parsed.
+            std::optional<ParseStats::Scope> scope(std::in_place, stats, Phase::Tokenize, exename, "boost");
+            po::options_description used;
+            bool resolved = selectUsedOptions(merged, args, used);
+            auto parse_results = po::command_line_parser(std::vector<std::string>(args.begin(), args.end()))
+                                     .options(resolved ? used : merged.partial)
+                                     .positional(merged.positional)
+                                     .run();
+            parse_results.description = &merged.partial;
+            if (merged.sink)
+            {
+                auto &options = parse_results.options;
+                auto first =
+                    std::stable_partition(options.begin(), options.end(), [&merged](const po::option &opt) {
+                        return opt.string_key != merged.sink_option->long_name();
+                    });
+                std::move(first, options.end(), std::back_inserter(streamed_options));
+                options.erase(first, options.end());
+                size_t skipped = 0;
+                for (const auto &it : streamed_options)
+                {
+                    for (const auto &value : it.value)
+                    {
+                        if (skipped < streamed)
+                        {
+                            skipped++; // pushed or deferred by tokenize() already
+                            continue;
+                        }
+                        stream(merged, value, deferred);
+                    }
+                }
+            }
+            scope->setOptionsMatched(parse_results.options.size() + streamed_options.size());
+            scope.emplace(stats, Phase::Store, exename);
+            scope->setOptionsMatched(parse_results.options.size());
+            po::store(parse_results, vm);
+        }
+        if (config_sources_.has_value())
+        {
+            // store() keeps the values stored before, so the sources are
+            // stored in the order of precedence
+            ParseStats::Scope scope(stats, Phase::ConfigSources, exename);
+            scope.setOptionsMatched(storeConfigSources(merged, config_sources_.value(), vm));
+        }
+    }
+    catch (const po::unknown_option &e)
+    {
+        throw UnknownOption(e, suggestOptions(merged, e.get_option_name()));
+    }
+    {
+        ParseStats::Scope scope(stats, Phase::Notify, exename);
+        boost::program_options::notify(vm);
+    }
+    if (!deferred.empty())
+    {
+        ParseStats::Scope scope(stats, Phase::PositionalSink, exename);
+        scope.setOptionsMatched(deferred.size());
+        for (auto value : deferred)
+        {
+            if (value == "-")
+            {
+                merged.sink->read(merged.sink->input());
+            }
+            else
+            {
+                merged.sink->push(value);
+            }
+        }
+    }
+    for (auto it : groups_)
+    {
+        ParseStats::Scope scope(stats, Phase::Update, exename, it->groupName());
+        if (ParseStats::active(stats))
+        {
+            scope.setOptionsMatched(matchedCount(*it, vm));
+        }
+        it->update(vm);
+    }
+    values_ = std::move(vm);
+    activated = true;
+    return true;
+}
+
+void Parser::validate()
+{
+    for (auto it : groups_)
+    {
+        ParseStats::Scope scope(parse_stats_.get(), ParseStats::Phase::Validate, exename, it->groupName());
+        it->validate();
+    }
+}
+
+size_t Parser::optionsCount() const
+{
+    size_t res = 0;
+    for (const auto &it : groups_)
+    {
+        res += it->partial.options().size();
+    }
+    return res;
+}
+
+const MergedDescription &Parser::mergedDescription()
+{
+    // addGroup resets the cache; the options count also catches the
+    // options added to a group after the group was added to the parser
+    size_t options_count = optionsCount();
+    if (merged_ && merged_->options_count == options_count)
+    {
+        return *merged_;
+    }
+    merged_ = std::make_shared<MergedDescription>();
+    merged_->options_count = options_count;
+    for (const auto &it : groups_)
+    {
+        merged_->partial.add(it->partial);
+        if (it->positional.max_total_count() != 0)
+        {
+            // only one group of options is allowed to have positional
+            // arguments
+            assert(merged_->positional.max_total_count() == 0);
+            merged_->positional = it->positional;
+            merged_->sink = it->positional_sink;
+        }
+    }
+    namespace po = boost::program_options;
+    for (const auto &opt : merged_->partial.options())
+    {
+        auto long_names = opt->long_names();
+        for (size_t n = 0; n < long_names.second; n++)
+        {
+            std::string_view name = long_names.first[n];
+            if (name.find('*') != std::string_view::npos || merged_->findLong(name))
+            {
+                continue; // wildcards are matched by boost only
+            }
+            merged_->long_names.emplace_back(name, opt);
+            merged_->long_index.insert(name, static_cast<uint32_t>(merged_->long_names.size() - 1),
+                                       [m = merged_.get()](uint32_t n) -> std::string_view {
+                                           return m->long_names[n].first;
+                                       });
+        }
+        std::string short_name = opt->canonical_display_name(po::command_line_style::allow_dash_for_short);
+        if (short_name.size() == 2 && short_name[0] == '-')
+        {
+            merged_->short_names[static_cast<unsigned char>(short_name[1])] = opt;
+        }
+    }
+    if (merged_->sink)
+    {
+        // the sink takes all the trailing positional values
+        unsigned trailing = std::numeric_limits<unsigned>::max() - 1;
+        merged_->sink_option = merged_->findLong(merged_->positional.name_for_position(trailing))->get();
+    }
+    return *merged_;
+}
+
+size_t Parser::storeConfigSources(const MergedDescription &merged, const ConfigSources &sources,
+                                  boost::program_options::variables_map &vm)
+{
+    namespace po = boost::program_options;
+    size_t count = 0;
+    auto add = [&count](po::parsed_options &parsed, const po::option_description &opt, std::string_view value) {
+        count++;
+        po::option &res = parsed.options.emplace_back();
+        res.string_key = opt.key(std::string());
+        res.value.emplace_back(value);
+    };
+    if (sources.use_environment)
+    {
+        std::string prefix = sources.environment_prefix.empty() ? ConfigSources::environmentPrefix(exename)
+                                                                : sources.environment_prefix;
+        if (!environment_.has_value() || environment_->prefix() != prefix)
+        {
+            environment_.emplace(prefix);
+        }
+        po::parsed_options parsed(&merged.partial);
+        for (const auto &[name, value] : environment_->variables())
+        {
+            auto opt = merged.findLong(name);
+            if (!opt && name.find('-') != std::string::npos)
+            {
+                opt = merged.findLong(Environment::underscoreName(name));
+            }
+            if (opt && opt->get() != merged.sink_option) // the other variables are not ours
+            {
+                add(parsed, **opt, value);
+            }
+        }
+        po::store(parsed, vm);
+    }
+    if (sources.config_file.has_value() &&
+        (sources.config_file_required || std::filesystem::exists(sources.config_file.value())))
+    {
+        po::parsed_options parsed(&merged.partial);
+        ConfigFile(sources.config_file.value()).visit([&](std::string_view name, std::string_view value) {
+            auto opt = merged.findLong(name);
+            if (!opt)
+            {
+                throw po::unknown_option(std::string(name));
+            }
+            if (opt->get() != merged.sink_option) // the positional sink takes the command line only
+            {
+                add(parsed, **opt, value);
+            }
+        });
+        po::store(parsed, vm);
+    }
+    return count;
+}
+
+} /* namespace program_options_heavy */
@@ -0,0 +1,289 @@
+#include <Parsers/ParserWithSubcommands.h>
+
+#include <Parsers/Suggestions.h>
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace program_options_heavy
+{
+
+ParserWithSubcommands::subcommands_t ParserWithSubcommands::getSubcommands()
+{
+    subcommands_t res;
+    for (size_t n = 0; n < subcommands_.size(); n++)
+    {
+        if (!subcommands_[n].isBranch())
+        {
+            res.emplace(subcommands_[n].name, instantiate(n));
+        }
+    }
+    return res;
+}
+
+std::vector<ParserWithSubcommands::subcommands_t::iterator> &ParserWithSubcommands::subcommandsOrder()
+{
+    if (!compat_subcommands_order_.empty())
+    {
+        return compat_subcommands_order_; // not changed since the last call
+    }
+    compat_subcommands_ = getSubcommands();
+    for (const auto &it : subcommands_)
+    {
+        if (!it.isBranch())
+        {
+            compat_subcommands_order_.push_back(compat_subcommands_.find(it.name));
+        }
+    }
+    return compat_subcommands_order_;
+}
+
+std::shared_ptr<Parser> ParserWithSubcommands::push_back(const std::string &subcommand_name,
+                                                         std::shared_ptr<Parser> val)
+{
+    return add(Subcommand{.name = subcommand_name, .parser = val}).parser;
+}
+
+void ParserWithSubcommands::addLazy(const std::string &subcommand_name, const std::string &description,
+                                    factory_t factory)
+{
+    add(Subcommand{.name = subcommand_name, .description = description, .factory = std::move(factory)});
+}
+
+std::shared_ptr<ParserWithSubcommands> ParserWithSubcommands::addBranch(const std::string &subcommand_name,
+                                                                        const std::string &description)
+{
+    auto res = std::make_shared<ParserWithSubcommands>(exename + " " + subcommand_name);
+    res->program_description = description;
+    return add(Subcommand{.name = subcommand_name, .description = description, .branch = res}).branch;
+}
+
+void ParserWithSubcommands::addLazyBranch(const std::string &subcommand_name, const std::string &description,
+                                          branch_factory_t factory)
+{
+    add(Subcommand{.name = subcommand_name, .description = description, .branch_factory = std::move(factory)});
+}
+
+std::shared_ptr<ParserWithSubcommands> ParserWithSubcommands::branch(std::string_view subcommand_name)
+{
+    auto pos = find(subcommand_name);
+    assert(pos.has_value() && subcommands_[pos.value()].isBranch());
+    instantiate(pos.value());
+    return subcommands_[pos.value()].branch;
+}
+
+bool ParserWithSubcommands::contains(std::string_view subcommand_name) const
+{
+    return find(subcommand_name).has_value();
+}
+
+const ParserWithSubcommands::Subcommand &ParserWithSubcommands::subcommand(std::string_view subcommand_name) const
+{
+    auto pos = find(subcommand_name);
+    assert(pos.has_value());
+    return subcommands_[pos.value()];
+}
+
+bool ParserWithSubcommands::isInstantiated(std::string_view subcommand_name) const
+{
+    auto pos = find(subcommand_name);
+    assert(pos.has_value());
+    return subcommands_[pos.value()].parser != nullptr || subcommands_[pos.value()].branch != nullptr;
+}
+
+const std::string &ParserWithSubcommands::subcommandDescription(std::string_view subcommand_name) const
+{
+    auto pos = find(subcommand_name);
+    assert(pos.has_value());
+    const Subcommand &subcmd = subcommands_[pos.value()];
+    if (subcmd.parser)
+    {
+        return subcmd.parser->program_description;
+    }
+    return subcmd.branch ? subcmd.branch->program_description : subcmd.description;
+}
+
+std::shared_ptr<Parser> ParserWithSubcommands::operator[](const std::string &subcommand_name)
+{
+    auto pos = find(subcommand_name);
+    if (!pos.has_value())
+    {
+        return add(Subcommand{.name = subcommand_name, .parser = std::make_shared<Parser>(exename)}).parser;
+    }
+    return leaf(pos.value());
+}
+
+std::shared_ptr<Parser> ParserWithSubcommands::at(std::string_view subcommand_name)
+{
+    auto pos = find(subcommand_name);
+    assert(pos.has_value());
+    return leaf(pos.value());
+}
+
+void ParserWithSubcommands::setDefaultSubcommand(const std::string &subcommand_name, bool hide)
+{
+    assert(find(subcommand_name).has_value());
+    default_subcommand_name_ = subcommand_name;
+    is_default_subcommand_enabled_ = true;
+    hide_default_subcommand_name_ = hide; // if true the default subcommand name will be replaced by
+                                          // empty string in the help message
+}
+
+bool ParserWithSubcommands::parse(int argc, const char *argv[])
+{
+    assert(!subcommands_.empty());
+    ParseStats *stats = parse_stats_.get();
+    ParseStats::Scope parse_scope(stats, ParseStats::Phase::Parse, exename);
+    std::optional<ParseStats::Scope> dispatch_scope(std::in_place, stats, ParseStats::Phase::Dispatch, exename);
+    std::optional<uint32_t> selected;
+    if (argc >= 2)
+    {
+        selected = find(argv[1]);
+        if (selected.has_value())
+        {
+            argc--;
+            argv++;
+        };
+    };
+    if (!selected.has_value())
+    {
+        // Subcommand is unknown or no subcommand is specified, select the
+        // default subcommand
+        if (is_default_subcommand_enabled_)
+        {
+            selected = find(default_subcommand_name_);
+            assert(selected.has_value());
+        }
+        else if (argc >= 2 && argv[1][0] != '-')
+        {
+            std::vector<std::string_view> names;
+            names.reserve(subcommands_.size());
+            for (const auto &it : subcommands_)
+            {
+                names.push_back(it.name);
+            }
+            throw UnknownSubcommand(argv[1], suggestions(argv[1], names));
+        }
+        else
+        {
+            throw std::runtime_error("Invalid program arguments");
+        }
+    };
+    selected_subcommand_ = selected.value();
+    dispatch_scope->setDetail(subcommands_[selected_subcommand_].name);
+    auto parser = instantiate(selected_subcommand_);
+    const auto &branch = subcommands_[selected_subcommand_].branch;
+    // the branch dispatches the next token with the same sources and stats
+    AbstractOptionsParser &selected_parser = parser ? static_cast<AbstractOptionsParser &>(*parser) : *branch;
+    if (config_sources_.has_value())
+    {
+        if (parser)
+        {
+            parser->setConfigSources(config_sources_.value());
+        }
+        else
+        {
+            branch->setConfigSources(config_sources_.value());
+        }
+    }
+    if (parse_stats_)
+    {
+        selected_parser.setParseStats(parse_stats_);
+    }
+    dispatch_scope.reset();
+    selected_parser.parse(argc, argv);
+    activated = true;
+    return true;
+}
+
+std::shared_ptr<Parser> ParserWithSubcommands::selectedSubcommand()
+{
+    const Subcommand &subcmd = subcommands_.at(selected_subcommand_);
+    return subcmd.branch ? subcmd.branch->selectedSubcommand() : subcmd.parser;
+}
+
+std::string ParserWithSubcommands::selectedPath() const
+{
+    const Subcommand &subcmd = subcommands_.at(selected_subcommand_);
+    return subcmd.branch ? subcmd.name + " " + subcmd.branch->selectedPath() : subcmd.name;
+}
+
+void ParserWithSubcommands::setConfigSources(ConfigSources sources)
+{
+    if (sources.use_environment && sources.environment_prefix.empty())
+    {
+        sources.environment_prefix = ConfigSources::environmentPrefix(exename);
+    }
+    config_sources_ = std::move(sources);
+}
+
+std::optional<uint32_t> ParserWithSubcommands::find(std::string_view subcommand_name) const
+{
+    return index_.find(subcommand_name, [this](uint32_t n) -> std::string_view { return subcommands_[n].name; });
+}
+
+ParserWithSubcommands::Subcommand &ParserWithSubcommands::add(Subcommand subcmd)
+{
+    if (find(subcmd.name).has_value())
+    {
+        throw std::runtime_error("The specified subcommand_name is already "
+                                 "present in SubcommandsParser");
+    }
+    subcommands_.push_back(std::move(subcmd));
+    compat_subcommands_order_.clear(); // rebuilt by the next subcommandsOrder()
+    uint32_t n = static_cast<uint32_t>(subcommands_.size() - 1);
+    index_.insert(subcommands_[n].name, n,
+                  [this](uint32_t n) -> std::string_view { return subcommands_[n].name; });
+    return subcommands_[n];
+}
+
+std::shared_ptr<Parser> ParserWithSubcommands::instantiate(size_t n)
+{
+    Subcommand &subcmd = subcommands_[n];
+    if (subcmd.isBranch())
+    {
+        if (!subcmd.branch)
+        {
+            subcmd.branch = subcmd.branch_factory();
+            if (!subcmd.branch)
+            {
+                throw std::runtime_error("The factory of the branch " + subcmd.name + " returned nullptr");
+            }
+            subcmd.branch->exename = exename + " " + subcmd.name;
+            if (subcmd.branch->program_description.empty())
+            {
+                subcmd.branch->program_description = subcmd.description;
+            }
+            subcmd.branch_factory = nullptr;
+        }
+        return nullptr;
+    }
+    if (!subcmd.parser)
+    {
+        subcmd.parser = subcmd.factory();
+        if (!subcmd.parser)
+        {
+            throw std::runtime_error("The factory of the subcommand " + subcmd.name + " returned nullptr");
+        }
+        if (subcmd.parser->program_description.empty())
+        {
+            subcmd.parser->program_description = subcmd.description;
+        }
+        subcmd.factory = nullptr;
+    }
+    return subcmd.parser;
+}
+
+std::shared_ptr<Parser> ParserWithSubcommands::leaf(size_t n)
+{
+    if (subcommands_[n].isBranch())
+    {
+        throw std::runtime_error("The subcommand " + subcommands_[n].name + " is a branch");
+    }
+    return instantiate(n);
+}
+
+} /* namespace program_options_heavy */
@@ -0,0 +1,91 @@
+#include <Parsers/TypedValue.h>
+
+#include <cctype>
+
+namespace program_options_heavy
+{
+
+InvalidValue::InvalidValue(const std::string &token, const std::string &reason)
+    : boost::program_options::invalid_option_value(token), reason_{reason}
+{
+    m_error_template += ": " + reason;
+}
+
+namespace detail
+{
+
+namespace
+{
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t n = 0; n < a.size(); n++)
+    {
+        if (std::tolower(static_cast<unsigned char>(a[n])) != b[n])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseBool(std::string_view token, bool &value, std::string &error)
+{
+    // the same words as po::value<bool> accepts
+    for (std::string_view it : {"true", "yes", "on", "1"})
+    {
+        if (equalsIgnoreCase(token, it))
+        {
+            value = true;
+            return true;
+        }
+    }
+    for (std::string_view it : {"false", "no", "off", "0"})
+    {
+        if (equalsIgnoreCase(token, it))
+        {
+            value = false;
+            return true;
+        }
+    }
+    error = "expected true, false, yes, no, on, off, 1 or 0";
+    return false;
+}
+
+bool parseDurationUnit(std::string_view unit, intmax_t &num, intmax_t &den, std::string &error)
+{
+    struct Unit
+    {
+        std::string_view name;
+        intmax_t num;
+        intmax_t den;
+    };
+    static constexpr Unit units[] = {{"ns", 1, 1000000000}, {"us", 1, 1000000}, {"ms", 1, 1000}, {"s", 1, 1},
+                                     {"min", 60, 1},        {"h", 3600, 1},      {"d", 86400, 1}};
+    for (const auto &it : units)
+    {
+        if (it.name == unit)
+        {
+            num = it.num;
+            den = it.den;
+            return true;
+        }
+    }
+    error = "unknown unit '" + std::string(unit) + "', expected ns, us, ms, s, min, h or d";
+    return false;
+}
+
+std::string unexpectedCharacter(std::string_view token, const char *pos)
+{
+    return "unexpected character '" + std::string(1, *pos) + "' at position " + std::to_string(pos - token.data());
+}
+
+} /* namespace detail */
+
+} /* namespace program_options_heavy */
@@ -0,0 +1,119 @@
+#include <Printers/PrettyPrinter.h>
+
+#include <cassert>
+#include <cctype>
+
+namespace program_options_heavy
+{
+
+namespace printers
+{
+
+void PrettyPrinter::visit(const AbstractItem &item)
+{
+    assert(false);
+}
+
+void PrettyPrinter::visit(const Paragraph &item)
+{
+    Rendering rendering(*this);
+    printText(level, item.text);
+}
+
+void PrettyPrinter::visit(const UnorderedList &lst)
+{
+    Rendering rendering(*this);
+    for (const auto &item : lst.items)
+    {
+        printText(level, item, "*");
+    }
+}
+
+void PrettyPrinter::visit(const Section &item)
+{
+    Rendering rendering(*this);
+    printTitle(level, item.title);
+    level++;
+    for (const auto &item : item.items)
+    {
+        item->accept(*this);
+    }
+    level--;
+}
+
+void PrettyPrinter::print(const std::shared_ptr<AbstractItem> item)
+{
+    sink_->write(render(item));
+}
+
+std::string_view PrettyPrinter::render(const std::shared_ptr<AbstractItem> item)
+{
+    begin();
+    item->accept(*this);
+    rendering_ = false;
+    return buffer_;
+}
+
+void PrettyPrinter::begin()
+{
+    use_escapes_ = colors_ == ColorMode::Always || (colors_ == ColorMode::Auto && sink_->isTerminal());
+    buffer_.clear();
+    rendering_ = true;
+}
+
+void PrettyPrinter::printTitle(size_t level, std::string_view str)
+{
+    if (str.empty())
+    {
+        return;
+    }
+    buffer_ += '\n';
+    // every line of the title is indented and escaped
+    for (size_t pos = 0;;)
+    {
+        size_t end = str.find('\n', pos);
+        indent(level);
+        if (level <= 1)
+        {
+            escape(bold());
+        }
+        for (auto ch : str.substr(pos, end - pos))
+        {
+            buffer_ += static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+        }
+        escape(reset());
+        buffer_ += '\n';
+        if (end == std::string_view::npos)
+        {
+            break;
+        }
+        pos = end + 1;
+    }
+}
+
+void PrettyPrinter::printText(size_t level, std::string_view str, std::string_view bullet)
+{
+    if (str.empty())
+    {
+        return;
+    }
+    indent(level + 1);
+    buffer_ += bullet;
+    // every line of the text is indented
+    for (size_t pos = 0;;)
+    {
+        size_t end = str.find('\n', pos);
+        buffer_.append(str.substr(pos, end - pos));
+        buffer_ += '\n';
+        if (end == std::string_view::npos)
+        {
+            break;
+        }
+        pos = end + 1;
+        indent(level + 1);
+    }
+}
+
+} /* namespace printers */
+
+} /* namespace program_options_heavy */
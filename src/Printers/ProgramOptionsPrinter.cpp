@@ -0,0 +1,62 @@
+#include <Printers/ProgramOptionsPrinter.h>
+
+#include <sstream>
+
+namespace program_options_heavy
+{
+
+namespace printers
+{
+
+std::shared_ptr<Section> ProgramOptionsPrinter::print(Parser &parser)
+{
+    auto document = Document::create();
+    auto res = document->make<Section>();
+    auto usage = res->add<Section>();
+    usage->title = "Usage";
+    usage->add_paragraph("\t" + shortHelp(parser));
+
+    auto description = res->add<Section>();
+    description->title = "Detailed description:";
+    description->add_paragraph(parser.program_description);
+
+    auto details = res->add<Section>();
+    details->title = "Details:";
+    for (auto &group : parser.groups())
+    {
+        print(*group, *details);
+    }
+    return document->share(res);
+}
+
+std::string ProgramOptionsPrinter::shortHelp(Parser &parser) const
+{
+    std::stringstream str;
+    str << parser.exename << " ";
+    for (const auto &group : parser.groups())
+    {
+        str << "[" << group->groupName() << "] ";
+    }
+    return str.str();
+}
+
+Section *ProgramOptionsPrinter::print(OptionsGroup &grp, Section &parent) const
+{
+    auto res = parent.add<Section>();
+    res->setTitle(grp.groupName());
+    res->add_paragraph(grp.description.view());
+    Document::Stream options_list(parent.document);
+    options_list << grp.visible;
+    res->add<Paragraph>()->text = options_list.text();
+    return res;
+}
+
+std::shared_ptr<Section> ProgramOptionsPrinter::print(OptionsGroup &grp) const
+{
+    auto document = Document::create();
+    return document->share(print(grp, *document->make<Section>()));
+}
+
+} /* namespace printers */
+
+} /* namespace program_options_heavy */
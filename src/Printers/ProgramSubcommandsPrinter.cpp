@@ -0,0 +1,217 @@
+#include <Printers/ProgramSubcommandsPrinter.h>
+
+#include <sstream>
+#include <stdexcept>
+
+namespace program_options_heavy
+{
+
+namespace printers
+{
+
+std::shared_ptr<Section> ProgramSubcommandsPrinter::print(ParserWithSubcommands &parser)
+{
+    options_groups_printed_already_.clear();
+    auto document = Document::create();
+    auto res = document->make<Section>();
+    auto usage = res->add<Section>();
+    usage->title = "Usage:";
+    for (auto &subcmd : parser.subcommands())
+    {
+        usage->add_paragraph("\t" + shortHelp(parser, subcmd));
+    }
+
+    auto description = res->add<Section>();
+    description->title = "Description:";
+    description->add_paragraph(parser.program_description);
+    for (auto &subcmd : parser.subcommands())
+    {
+        description->add_paragraph("\t" + subcommandDescription(parser, subcmd));
+    }
+
+    auto details = res->add<Section>();
+    details->title = "Details:";
+    for (auto &subcmd : parser.subcommands())
+    {
+        if (!subcmd.parser)
+        {
+            continue; // lazy subcommands and branches are not built just for the help message
+        }
+        print(*subcmd.parser, *details);
+    }
+    return document->share(res);
+}
+
+std::shared_ptr<Section> ProgramSubcommandsPrinter::print(ParserWithSubcommands &parser,
+                                                          std::string_view subcommand_path)
+{
+    auto &cache = cache_[&parser];
+    auto cached = cache.find(subcommand_path);
+    if (cached != cache.end())
+    {
+        return cached->second;
+    }
+    // only the branches on the path are built
+    ParserWithSubcommands *level = &parser;
+    std::string_view name = subcommand_path;
+    for (size_t space = name.find(' '); space != std::string_view::npos; space = name.find(' '))
+    {
+        std::string_view branch = name.substr(0, space);
+        if (!level->contains(branch) || !level->subcommand(branch).isBranch())
+        {
+            throw std::runtime_error("Unknown subcommand " + std::string(subcommand_path));
+        }
+        level = level->branch(branch).get();
+        name.remove_prefix(space + 1);
+    }
+    if (!level->contains(name))
+    {
+        throw std::runtime_error("Unknown subcommand " + std::string(subcommand_path));
+    }
+    auto res = level->subcommand(name).isBranch() ? print(*level->branch(name)) : printSubcommand(*level, name);
+    return cache.emplace(std::string(subcommand_path), res).first->second;
+}
+
+std::shared_ptr<Section> ProgramSubcommandsPrinter::printSubcommand(ParserWithSubcommands &parser,
+                                                                    std::string_view subcommand_name)
+{
+    options_groups_printed_already_.clear();
+    auto selected = parser.at(subcommand_name); // lazy subcommand is built here
+    const auto &subcmd = parser.subcommand(subcommand_name);
+
+    auto document = Document::create();
+    auto res = document->make<Section>();
+    auto usage = res->add<Section>();
+    usage->title = "Usage:";
+    usage->add_paragraph("\t" + shortHelp(parser, subcmd));
+
+    auto description = res->add<Section>();
+    description->title = "Description:";
+    description->add_paragraph("\t" + subcommandDescription(parser, subcmd));
+
+    auto details = res->add<Section>();
+    details->title = "Details:";
+    print(*selected, *details);
+
+    auto others = res->add<Section>();
+    others->title = "Other subcommands:";
+    for (auto &it : parser.subcommands())
+    {
+        if (it.name != subcmd.name)
+        {
+            others->add_paragraph("\t" + subcommandDescription(parser, it));
+        }
+    }
+    return document->share(res);
+}
+
+std::string ProgramSubcommandsPrinter::shortHelp(ParserWithSubcommands &parser,
+                                                 const ParserWithSubcommands::Subcommand &subcmd) const
+{
+    std::stringstream str;
+    str << parser.exename << " ";
+    if (subcmd.name == parser.defaultSubcommandName())
+    {
+        if (!parser.hideDefaultSubcommandName())
+        {
+            str << "[" << subcmd.name << "] ";
+        }
+    }
+    else
+    {
+        str << subcmd.name << " ";
+    }
+    if (subcmd.isBranch())
+    {
+        str << "<subcommand> ... ";
+        return str.str();
+    }
+    if (!subcmd.parser)
+    {
+        str << "[options] ";
+        return str.str();
+    }
+    const std::shared_ptr<Parser> opts = subcmd.parser;
+    for (const auto &group : opts->groups())
+    {
+        str << "[" << group->groupName() << "] ";
+    }
+    return str.str();
+}
+
+std::string ProgramSubcommandsPrinter::subcommandDescription(ParserWithSubcommands &parser,
+                                                             const ParserWithSubcommands::Subcommand &subcmd) const
+{
+    std::stringstream str;
+    if (subcmd.name != parser.defaultSubcommandName() || !parser.hideDefaultSubcommandName())
+    {
+        str << subcmd.name << " - ";
+    }
+    if (subcmd.parser)
+    {
+        str << subcmd.parser->program_description;
+    }
+    else
+    {
+        str << (subcmd.branch ? subcmd.branch->program_description : subcmd.description);
+    }
+    return str.str();
+}
+
+void ProgramSubcommandsPrinter::print(Parser &parser, Section &parent)
+{
+    for (const auto &it : parser.groups())
+    {
+        if (!options_groups_printed_already_.contains(it->groupName()))
+        {
+            print(*it, parent);
+            options_groups_printed_already_.insert(it->groupName());
+        }
+    }
+}
+
+Section *ProgramSubcommandsPrinter::print(OptionsGroup &grp, Section &parent) const
+{
+    auto res = parent.add<Section>();
+    res->setTitle(grp.groupName());
+    res->add_paragraph(grp.description.view());
+    Document::Stream options_list(parent.document);
+    options_list << grp.visible;
+    res->add<Paragraph>()->text = options_list.text();
+    return res;
+}
+
+std::vector<std::shared_ptr<Section>> ProgramSubcommandsPrinter::print(Parser &parser)
+{
+    auto document = Document::create();
+    auto parent = document->make<Section>();
+    print(parser, *parent);
+    std::vector<std::shared_ptr<Section>> res;
+    for (auto item : parent->items)
+    {
+        res.push_back(document->share(static_cast<Section *>(item)));
+    }
+    return res;
+}
+
+std::shared_ptr<Section> ProgramSubcommandsPrinter::print(OptionsGroup &grp) const
+{
+    auto document = Document::create();
+    return document->share(print(grp, *document->make<Section>()));
+}
+
+std::string ProgramSubcommandsPrinter::shortHelp(ParserWithSubcommands &parser,
+                                                 ParserWithSubcommands::subcommands_t::iterator it) const
+{
+    return shortHelp(parser, parser.subcommand(it->first));
+}
+
+std::string ProgramSubcommandsPrinter::subcommandDescription(ParserWithSubcommands &parser,
+                                                             ParserWithSubcommands::subcommands_t::iterator it) const
+{
+    return subcommandDescription(parser, parser.subcommand(it->first));
+}
+
+} /* namespace printers */
+
+} /* namespace program_options_heavy */
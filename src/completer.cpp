@@ -0,0 +1,379 @@
+#include <completer.h>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace program_options_heavy {
+
+Completer::Completer(std::shared_ptr<ParserWithSubcommands>& parser) : parser_{parser}, index_{buildIndex()} {
+}
+
+std::optional<std::vector<std::string>> Completer::completeFromCache(const completion::CompletionCache& cache,
+        uint64_t schema_hash) {
+    auto completion_line = getLineForCompletion();
+    if(!completion_line.has_value())
+        return std::nullopt;
+    auto identity = completion::ExecutableIdentity::current(schema_hash);
+    if(!identity.has_value())
+        return std::nullopt;
+    uint32_t flags = 0;
+    auto index = cache.load(identity.value(), &flags);
+    if(!index.has_value())
+        return std::nullopt;
+    Completer completer(std::move(index.value()));
+    completer.values_omitted_ = (flags & completion::CompletionCache::values_omitted) != 0;
+    auto res = completer.getCompletionVariants(completion_line.value());
+    if(completer.needs_parser_)
+        return std::nullopt;
+    return res;
+}
+
+std::optional<std::vector<std::string>> Completer::completeFromServer(std::optional<uint64_t> schema_hash,
+        const std::filesystem::path& socket_path) {
+    auto completion_line = getLineForCompletion();
+    if(!completion_line.has_value())
+        return std::nullopt;
+    return completion::CompletionClient(socket_path).complete(schema_hash, completion_line.value());
+}
+
+bool Completer::spawnServer(std::chrono::milliseconds idle_timeout, const std::filesystem::path& socket_path) {
+    pid_t pid = fork();
+    if(pid < 0)
+        return false;
+    if(pid > 0) {
+        waitpid(pid, nullptr, 0);
+        return true;
+    }
+    // the intermediate child exits at once, so the server is not a
+    // child of the caller and does not hold its stdout
+    setsid();
+    if(fork() != 0)
+        _exit(0);
+    int null_fd = open("/dev/null", O_RDWR);
+    if(null_fd >= 0) {
+        dup2(null_fd, STDIN_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        close(null_fd);
+    }
+    completion::CompletionServer server(socket_path, index_.hash(),
+        [this](const std::string& line) { return getCompletionVariants(line); }, idle_timeout);
+    if(server.listen())
+        server.run();
+    _exit(0);
+}
+
+bool Completer::saveCache(const completion::CompletionCache& cache, uint64_t schema_hash) {
+    auto identity = completion::ExecutableIdentity::current(schema_hash);
+    if(!identity.has_value())
+        return false;
+    bool values_omitted = values_omitted_ || !value_completers_.empty();
+    auto flags = [&values_omitted]() { return values_omitted ? completion::CompletionCache::values_omitted : 0; };
+    if((!lazy_.empty() || !branches_.empty()) && parser_) {
+        // the cache is used without the parser, so it needs the options of
+        // all the subcommands and the nested levels
+        auto index = buildCacheIndex(values_omitted);
+        return cache.save(index, identity.value(), flags());
+    }
+    return cache.save(index_, identity.value(), flags());
+}
+
+std::vector<std::string> Completer::getCompletionVariants() {
+    auto completion_line = getLineForCompletion();
+    if(completion_line.has_value())
+        return getCompletionVariants(completion_line.value());
+    return {};
+}
+
+std::vector<std::string> Completer::getCompletionVariants(const std::string& completion_line) {
+    auto words = split(completion_line);
+    if(!completion_line.empty() && completion_line.back() == ' ')
+        words.push_back(std::string_view()); // the cursor is at the start of a new word
+    return getCompletionVariants(words);
+}
+
+std::tuple<std::string_view, std::string_view, std::vector<std::string_view>> Completer::byRoles(
+        const std::vector<std::string_view>& words, bool with_exename) {
+    std::string_view exec_name;
+    std::string_view command_name;
+    std::vector<std::string_view> options;
+    size_t processed = 0;
+    if(with_exename && !index_.exename().empty() && words.size() > 0) {
+        exec_name = words[0];
+        processed++;
+    }
+    if(words.size() > processed && words[processed].find('-') != 0) {
+        command_name = words[processed];
+        processed++;
+    }
+    for(size_t n = processed; n < words.size(); n++) {
+        options.push_back(words[n]);
+    }
+    return {exec_name, command_name, options};
+}
+
+std::vector<std::string> Completer::getCompletionVariants(const std::vector<std::string_view>& words) {
+    auto [exec_name, command_name, options] = byRoles(words);
+
+    // match the name of the executable
+    std::string_view exename = index_.exename();
+    if(!exename.empty() && exec_name != exename) {
+        if(exename.starts_with(exec_name))
+            return {std::string(exename)};
+        return {};
+    }
+    return completeCommand(command_name, options);
+}
+
+std::vector<std::string> Completer::completeCommand(std::string_view command_name,
+        const std::vector<std::string_view>& options, const std::string& level) {
+    // match the name of the command at this level, the deeper levels of the
+    // cache index are skipped
+    std::string path = level + std::string(command_name);
+    std::vector<completion::CompletionIndex::Entry> commands;
+    for(const auto& entry : index_.commandNames(path)) {
+        if(index_.str(entry).find(' ', level.size()) == std::string_view::npos)
+            commands.push_back(entry);
+    }
+    if(commands.empty() || index_.str(commands.front()) != path) {
+        std::vector<std::string> res;
+        for(const auto& entry : commands)
+            res.emplace_back(index_.str(entry).substr(level.size()));
+        return res;
+    }
+    uint32_t command = commands.front().item;
+    if(auto branch = branches_.find(command); branch != branches_.end()) {
+        if(options.empty())
+            return {std::string(command_name)};
+        if(!branch->second) {
+            auto parser = parser_->branch(command_name);
+            branch->second = std::make_shared<Completer>(parser);
+            branch->second->max_value_candidates_ = max_value_candidates_;
+        }
+        auto [unused, nested_command, nested_options] = branch->second->byRoles(options, false);
+        return branch->second->completeCommand(nested_command, nested_options);
+    }
+    if(!index_.commandNames(path + " ").empty()) {
+        // the branch in the cache index, see buildCacheIndex
+        if(options.empty())
+            return {std::string(command_name)};
+        auto [unused, nested_command, nested_options] = byRoles(options, false);
+        return completeCommand(nested_command, nested_options, path + " ");
+    }
+    const completion::CompletionIndex& options_index = optionsIndex(command);
+
+    if(values_omitted_ && mayBeValue(options)) {
+        // the value completers are not in the cache
+        needs_parser_ = true;
+        return {};
+    }
+    if(auto values = completeValue(command_name, options_index, command, options); values.has_value())
+        return values.value();
+
+    // mark all used options
+    boost::dynamic_bitset<> used(options_index.optionsCount(command));
+    bool last_option_full_match = false;
+    for(size_t idx = 0; idx < options.size(); idx++) {
+        for(const auto& entry : options_index.optionNames(command, options[idx])) {
+            if(entry.length != options[idx].size())
+                break; // the whole matches go first in the sorted range
+            used.set(entry.item);
+            if(idx + 1 == options.size())
+                last_option_full_match = true;
+        }
+    }
+
+    // last option should be processed separately
+    if(options.size() > 0 && !last_option_full_match) {
+        std::vector<completion::CompletionIndex::Entry> matches;
+        for(const auto& entry : options_index.optionNames(command, options.back())) {
+            if(!used.test(entry.item))
+                matches.push_back(entry);
+        }
+        // one variant per option: the first of its names that matches
+        std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b) {
+            return a.item != b.item ? a.item < b.item : a.rank < b.rank;
+        });
+        std::vector<std::string> res;
+        for(size_t n = 0; n < matches.size(); n++) {
+            if(n == 0 || matches[n].item != matches[n - 1].item)
+                res.emplace_back(options_index.str(matches[n]));
+        }
+        return res;
+    }
+
+    std::vector<std::string> res;
+    for(uint32_t n = 0; n < options_index.optionsCount(command); n++) {
+        if(!used.test(n))
+            res.emplace_back(options_index.canonicalName(command, n));
+    }
+    return res;
+}
+
+std::optional<std::vector<std::string>> Completer::completeValue(std::string_view command_name,
+        const completion::CompletionIndex& options_index, uint32_t command,
+        const std::vector<std::string_view>& options) {
+    auto completers = value_completers_.find(command_name);
+    if(options.empty() || completers == value_completers_.end())
+        return std::nullopt;
+    auto completerOf = [&](std::string_view option) -> const completion::ValueCompleter* {
+        for(const auto& entry : options_index.optionNames(command, option)) {
+            if(entry.length != option.size())
+                break;
+            return completers->second[entry.item].get();
+        }
+        return nullptr;
+    };
+    std::string_view last = options.back();
+    size_t eq = last.find('=');
+    if(last.starts_with("--") && eq != std::string_view::npos) {
+        auto completer = completerOf(last.substr(0, eq));
+        if(!completer)
+            return std::nullopt;
+        auto res = completer->candidates(last.substr(eq + 1), max_value_candidates_);
+        for(auto& it : res)
+            it.insert(0, last.substr(0, eq + 1));
+        return res;
+    }
+    if(options.size() < 2)
+        return std::nullopt;
+    auto completer = completerOf(options[options.size() - 2]);
+    if(!completer)
+        return std::nullopt;
+    return completer->candidates(last, max_value_candidates_);
+}
+
+bool Completer::mayBeValue(const std::vector<std::string_view>& options) {
+    if(options.empty())
+        return false;
+    std::string_view last = options.back();
+    if(last.starts_with("--") && last.find('=') != std::string_view::npos)
+        return true;
+    if(options.size() < 2 || last.starts_with('-'))
+        return false;
+    std::string_view prev = options[options.size() - 2];
+    return prev.starts_with('-') && prev.find('=') == std::string_view::npos;
+}
+
+completion::CompletionIndex Completer::buildIndex() {
+    completion::CompletionIndex res(parser_->exename);
+    for(const auto& it : parser_->subcommands()) {
+        if(it.isBranch()) {
+            // the commands of the branch are indexed by its own completer
+            branches_.try_emplace(static_cast<uint32_t>(res.commandsCount()), nullptr);
+            res.addCommand(it.name, {});
+            continue;
+        }
+        if(!it.parser) {
+            lazy_[static_cast<uint32_t>(res.commandsCount())] = std::nullopt;
+            res.addCommand(it.name, {});
+            continue;
+        }
+        res.addCommand(it.name, getOptions(it.name, *parser_->at(it.name)));
+    }
+    return res;
+}
+
+completion::CompletionIndex Completer::buildCacheIndex(bool& has_value_completers) {
+    completion::CompletionIndex res(parser_->exename);
+    addCommands(res, *parser_, "", has_value_completers);
+    return res;
+}
+
+void Completer::addCommands(completion::CompletionIndex& index, ParserWithSubcommands& parser,
+        const std::string& level, bool& has_value_completers) {
+    for(const auto& it : parser.subcommands()) {
+        std::string path = level + it.name;
+        if(it.isBranch()) {
+            index.addCommand(path, {});
+            addCommands(index, *parser.branch(it.name), path + " ", has_value_completers);
+            continue;
+        }
+        index.addCommand(path, optionNames(*parser.at(it.name), has_value_completers));
+    }
+}
+
+std::vector<std::span<const std::string_view>> Completer::optionNames(Parser& parser,
+        bool& has_value_completers) {
+    std::vector<std::span<const std::string_view>> options;
+    for(const auto& grp : parser.groups()) {
+        for(const auto& opt : grp->schema().options())
+            options.push_back(opt.names);
+        has_value_completers = has_value_completers || grp->schema().hasValueCompleters();
+    }
+    return options;
+}
+
+std::vector<std::span<const std::string_view>> Completer::getOptions(const std::string& command_name,
+        Parser& parser) {
+    bool has_value_completers = false;
+    auto options = optionNames(parser, has_value_completers);
+    if(has_value_completers) {
+        auto& completers = value_completers_[command_name];
+        completers.clear();
+        for(const auto& grp : parser.groups()) {
+            for(const auto& opt : grp->schema().options())
+                completers.push_back(opt.completer);
+        }
+    }
+    return options;
+}
+
+const completion::CompletionIndex& Completer::optionsIndex(uint32_t& command) {
+    auto lazy = lazy_.find(command);
+    if(lazy == lazy_.end())
+        return index_;
+    if(!lazy->second.has_value()) {
+        std::string name(index_.commandName(command));
+        lazy->second.emplace();
+        lazy->second->addCommand(name, getOptions(name, *parser_->at(name)));
+    }
+    command = 0;
+    return lazy->second.value();
+}
+
+std::string_view Completer::trim(std::string_view str) {
+    size_t trim_from_start = str.find_first_not_of(' ');
+    size_t trim_from_end = str.find_last_not_of(' ');
+    if(trim_from_start != std::string_view::npos) {
+        assert(trim_from_end != std::string_view::npos);
+        size_t len = trim_from_end - trim_from_start + 1;
+        return str.substr(trim_from_start, len);
+    }
+    return str.substr(0, 0); //empty string view
+}
+
+std::vector<std::string_view> Completer::split(std::string_view line) {
+    std::vector<std::string_view> res;            
+    size_t start = 0;
+    size_t finish;            
+    do {
+        finish = line.find(' ', start+1);
+        auto substr = line.substr(start, finish - start);
+        substr = trim(substr);
+        if(substr.length() > 0) {
+            res.push_back(substr);
+        }
+        start = finish + 1;
+    } while(finish != std::string::npos);
+    return res;
+}
+
+std::optional<std::string> Completer::getLineForCompletion() {
+    if(const char* cstr = getenv("COMP_LINE")) {
+        // complete the word under the cursor, ignore the rest of the line
+        const char* point = getenv("COMP_POINT");
+        return std::string(completion::CompletionProtocol::lineToPoint(cstr, point ? point : ""));
+    } else {
+        return std::nullopt;
+    }
+}
+
+} /* program_options_heavy */
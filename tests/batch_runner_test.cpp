@@ -0,0 +1,158 @@
+#include <Parsers/BatchRunner.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+
+namespace po = boost::program_options;
+using program_options_heavy::BatchRunner;
+using program_options_heavy::OptionsGroup;
+using program_options_heavy::ParserWithSubcommands;
+using program_options_heavy::tokenizeCommandLine;
+
+namespace {
+
+class RunOptions : public OptionsGroup {
+  public:
+    RunOptions() : OptionsGroup("run group") {
+        addPartialVisible("dim,d", po::value<size_t>(&dim)->required(), "hypercube dimension");
+        addPartialVisible("name,n", po::value<std::string>(&name), "name");
+    }
+    size_t dim{0};
+    std::string name;
+};
+
+std::shared_ptr<ParserWithSubcommands> makeParser() {
+    auto parser = std::make_shared<ParserWithSubcommands>("programname");
+    (*parser)["run"]->addGroup(std::make_shared<RunOptions>());
+    (*parser)["noop"];
+    return parser;
+}
+
+} // namespace
+
+TEST(BATCHRUNNER, TOKENIZE) {
+    ASSERT_EQ(tokenizeCommandLine("  run -d 10\t--name 'a b' \"c \\\"d\\\"\" e\\ f "),
+              (std::vector<std::string>{"run", "-d", "10", "--name", "a b", "c \"d\"", "e f"}));
+    ASSERT_EQ(tokenizeCommandLine("run ''"), (std::vector<std::string>{"run", ""}));
+    EXPECT_THROW(tokenizeCommandLine("run 'abc"), std::runtime_error);
+}
+
+TEST(BATCHRUNNER, RUN) {
+    std::stringstream manifest;
+    const size_t lines_count = 1000;
+    size_t expected_sum = 0;
+    size_t first_error_line = 0;
+    for (size_t n = 1; n <= lines_count; n++) {
+        if (n % 100 == 0) {
+            manifest << "run --dim x\n"; // invalid value
+            if (first_error_line == 0)
+                first_error_line = n + n / 10 - 1; // comments take two lines
+        } else if (n % 10 == 0) {
+            manifest << "# comment\n\n";
+        } else {
+            manifest << "run -d " << n << " --name line" << n << "\n";
+            expected_sum += n;
+        }
+    }
+    manifest << "noop\n"; // no handler
+
+    std::atomic<size_t> sum{0};
+    BatchRunner runner(makeParser, 4);
+    runner.setCompletion(BatchRunner::Completion::Ordered);
+    runner.setQueueSize(16);
+    runner.addHandler("run", [&sum](ParserWithSubcommands& parser) {
+        auto options = std::dynamic_pointer_cast<RunOptions>(parser.selectedSubcommand()->groups().front());
+        ASSERT_EQ(options->name, "line" + std::to_string(options->dim));
+        sum += options->dim;
+    });
+    std::vector<size_t> reported;
+    runner.setResultCallback([&reported](const BatchRunner::LineResult& result) { reported.push_back(result.line_number); });
+
+    auto report = runner.run(manifest);
+    ASSERT_EQ(sum, expected_sum);
+    ASSERT_EQ(report.processed, lines_count - 90 + 1);
+    ASSERT_EQ(report.failed, 11);
+    ASSERT_EQ(report.errors.front().line_number, first_error_line);
+    ASSERT_EQ(report.errors.back().line, "noop");
+    ASSERT_TRUE(std::is_sorted(reported.begin(), reported.end()));
+    ASSERT_EQ(reported.size(), report.processed);
+}
+
+TEST(BATCHRUNNER, FRESH_VALUES_PER_LINE) {
+    // a single worker runs both lines, the second line must not see the name
+    // set by the first one
+    std::stringstream manifest("run -d 1 --name first\nrun -d 2\n");
+    std::map<size_t, std::string> names;
+    BatchRunner runner(makeParser, 1);
+    runner.addHandler("run", [&names](ParserWithSubcommands& parser) {
+        auto options = std::dynamic_pointer_cast<RunOptions>(parser.selectedSubcommand()->groups().front());
+        names[options->dim] = options->name;
+    });
+    auto report = runner.run(manifest);
+    ASSERT_EQ(report.failed, 0);
+    ASSERT_EQ(names, (std::map<size_t, std::string>{{1, "first"}, {2, ""}}));
+}
+
+TEST(BATCHRUNNER, PARSER_PER_WORKER) {
+    // the parser is rebuilt only after the failed line
+    std::stringstream manifest("run -d 1 --name a\nrun -d 2 --name b\nnoop\nrun -d 3 --name c\n"
+                               "run -d 4\nrun -d x\nrun -d 5 --name e\n");
+    size_t built = 0;
+    std::map<size_t, std::string> names;
+    BatchRunner runner([&built]() { built++; return makeParser(); }, 1);
+    runner.addHandler("run", [&names](ParserWithSubcommands& parser) {
+        auto options = std::dynamic_pointer_cast<RunOptions>(parser.selectedSubcommand()->groups().front());
+        names[options->dim] = options->name;
+    });
+    runner.addHandler("noop", [](ParserWithSubcommands&) {});
+    auto report = runner.run(manifest);
+    ASSERT_EQ(report.failed, 1);
+    ASSERT_EQ(built, 2);
+    ASSERT_EQ(names, (std::map<size_t, std::string>{{1, "a"}, {2, "b"}, {3, "c"}, {4, ""}, {5, "e"}}));
+}
+
+TEST(BATCHRUNNER, ALTERNATING_OPTIONS) {
+    // every other line leaves out --name, the variable is reset instead of
+    // building the parser again
+    std::stringstream manifest;
+    for (size_t n = 1; n <= 100; n++) {
+        manifest << "run -d " << n << (n % 2 ? " --name odd" : "") << "\n";
+    }
+    size_t built = 0;
+    std::map<size_t, std::string> names;
+    BatchRunner runner([&built]() { built++; return makeParser(); }, 1);
+    runner.addHandler("run", [&names](ParserWithSubcommands& parser) {
+        auto options = std::dynamic_pointer_cast<RunOptions>(parser.selectedSubcommand()->groups().front());
+        names[options->dim] = options->name;
+    });
+    auto report = runner.run(manifest);
+    ASSERT_EQ(report.failed, 0);
+    ASSERT_EQ(built, 1);
+    ASSERT_EQ(names.size(), 100);
+    ASSERT_EQ(names[99], "odd");
+    ASSERT_EQ(names[100], "");
+
+    // the variable of an unknown type can't be reset, the parser is rebuilt
+    std::stringstream tagged("run -d 1 --tag a\nrun -d 2\nrun -d 3\n");
+    built = 0;
+    char tag = '\0';
+    std::map<size_t, char> tags;
+    BatchRunner tag_runner([&built, &tag]() {
+        built++;
+        tag = '\0';
+        auto parser = makeParser();
+        auto group = std::make_shared<OptionsGroup>("tag group");
+        group->addPartialVisible("tag", po::value<char>(&tag), "tag");
+        (*parser)["run"]->addGroup(group);
+        return parser;
+    }, 1);
+    tag_runner.addHandler("run", [&tags, &tag](ParserWithSubcommands& parser) {
+        auto options = std::dynamic_pointer_cast<RunOptions>(parser.selectedSubcommand()->groups().front());
+        tags[options->dim] = tag;
+    });
+    report = tag_runner.run(tagged);
+    ASSERT_EQ(report.failed, 0);
+    ASSERT_EQ(built, 2);
+    ASSERT_EQ(tags, (std::map<size_t, char>{{1, 'a'}, {2, '\0'}, {3, '\0'}}));
+}
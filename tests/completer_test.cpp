@@ -2,6 +2,12 @@
 #include<Parsers/ParserWithSubcommands.h>
 #include<gtest/gtest.h>
 
+#include<algorithm>
+#include<filesystem>
+#include<fstream>
+#include<thread>
+#include<unistd.h>
+
 namespace po = boost::program_options;
 using program_options_heavy::ParserWithSubcommands;
 using program_options_heavy::OptionsGroup;
@@ -113,3 +119,285 @@ TEST_F(CompleterFixture, OptionsMatch3) {
     std::vector<std::string> expected = {};
     ASSERT_EQ(received, expected);
 }
+
+TEST_F(CompleterFixture, OptionsShortNameUsed) {
+    Completer completer(commands_parser);
+    auto received = completer.getCompletionVariants("exename run -d -v");
+    std::vector<std::string> expected = {"--common"};
+    ASSERT_EQ(received, expected);
+}
+
+TEST_F(CompleterFixture, OptionsDashPrefix) {
+    Completer completer(commands_parser);
+    auto received = completer.getCompletionVariants("exename run --common -");
+    std::vector<std::string> expected = {"--dim", "-v"};
+    ASSERT_EQ(received, expected);
+}
+
+TEST_F(CompleterFixture, CacheRoundTrip) {
+    using program_options_heavy::completion::CompletionCache;
+    using program_options_heavy::completion::ExecutableIdentity;
+    auto path = std::filesystem::temp_directory_path() / ("poheavy_completer_test_" + std::to_string(getpid()) + ".idx");
+    CompletionCache cache(path);
+    ExecutableIdentity identity{100, 200, 300};
+    ASSERT_TRUE(cache.save(Completer(commands_parser).index(), identity));
+
+    ASSERT_FALSE(cache.load(ExecutableIdentity{100, 201, 300}).has_value());
+    auto index = cache.load(identity);
+    ASSERT_TRUE(index.has_value());
+    Completer completer(std::move(index.value()));
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(completer.getCompletionVariants("exename"), (std::vector<std::string>{"gather", "run"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename run -d -v"), (std::vector<std::string>{"--common"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename gather --g"), (std::vector<std::string>{"--gather"}));
+}
+
+TEST_F(CompleterFixture, CacheCorrupted) {
+    using program_options_heavy::completion::CompletionCache;
+    using program_options_heavy::completion::CompletionIndex;
+    using program_options_heavy::completion::ExecutableIdentity;
+    auto path = std::filesystem::temp_directory_path() / ("poheavy_completer_test_" + std::to_string(getpid()) + ".idx");
+    CompletionCache cache(path);
+    ExecutableIdentity identity{100, 200, 300};
+    ASSERT_TRUE(cache.save(Completer(commands_parser).index(), identity));
+    ASSERT_TRUE(cache.load(identity).has_value());
+
+    // the size of the file is right, the range of the first command is not
+    CompletionCache::Header header;
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    CompletionIndex::Command command;
+    file.seekg(sizeof(header) + header.pool_size);
+    file.read(reinterpret_cast<char*>(&command), sizeof(command));
+    command.first_entry = header.option_entries_count;
+    file.seekp(sizeof(header) + header.pool_size);
+    file.write(reinterpret_cast<const char*>(&command), sizeof(command));
+    file.close();
+    ASSERT_FALSE(cache.load(identity).has_value());
+    std::filesystem::remove(path);
+}
+
+TEST_F(CompleterFixture, CacheCountsOverflow) {
+    using program_options_heavy::completion::CompletionCache;
+    using program_options_heavy::completion::ExecutableIdentity;
+    auto path = std::filesystem::temp_directory_path() / ("poheavy_completer_test_" + std::to_string(getpid()) + ".idx");
+    CompletionCache cache(path);
+    ExecutableIdentity identity{100, 200, 300};
+    ASSERT_TRUE(cache.save(Completer(commands_parser).index(), identity));
+
+    // the sum of the entry counts wraps to the right value in 32 bits
+    CompletionCache::Header header;
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    uint32_t entries = header.command_entries_count + header.option_entries_count;
+    header.command_entries_count = 0xFFFFFFFF;
+    header.option_entries_count = entries + 1;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    ASSERT_FALSE(cache.load(identity).has_value());
+    std::filesystem::remove(path);
+}
+
+TEST_F(CompleterFixture, ServerRoundTrip) {
+    using program_options_heavy::completion::CompletionClient;
+    using program_options_heavy::completion::CompletionServer;
+    // the socket is created in a private directory only
+    std::string dir_template = (std::filesystem::temp_directory_path() / "poheavy_completer_test_XXXXXX").string();
+    ASSERT_NE(mkdtemp(dir_template.data()), nullptr);
+    std::filesystem::path dir = dir_template;
+    std::filesystem::permissions(dir, std::filesystem::perms::group_exec, std::filesystem::perm_options::add);
+    ASSERT_FALSE(CompletionServer(dir / "server.sock", 0, nullptr).listen());
+    std::filesystem::permissions(dir, std::filesystem::perms::group_exec, std::filesystem::perm_options::remove);
+    auto path = dir / "server.sock";
+    Completer completer(commands_parser);
+    uint64_t hash = completer.index().hash();
+    CompletionServer server(path, hash, [&completer](const std::string& line) { return completer.getCompletionVariants(line); },
+                            std::chrono::seconds(5));
+    ASSERT_TRUE(server.listen());
+    std::thread thread([&server]() { server.run(); });
+
+    CompletionClient client(path, 5000);
+    auto received = client.complete(hash, "exename run --d");
+    ASSERT_TRUE(received.has_value());
+    ASSERT_EQ(received.value(), (std::vector<std::string>{"--dim"}));
+    received = client.complete(hash, "exename run --dim", 10);
+    ASSERT_TRUE(received.has_value());
+    ASSERT_EQ(received.value(), (std::vector<std::string>{"run"}));
+
+    // a client with another schema makes the server quit
+    ASSERT_FALSE(client.complete(hash + 1, "exename").has_value());
+    thread.join();
+    ASSERT_FALSE(std::filesystem::exists(path));
+    std::filesystem::remove(dir);
+}
+
+TEST_F(CompleterFixture, LazySubcommand) {
+    bool built = false;
+    commands_parser->addLazy("lazy", "lazy subcommand", [&built]() {
+        built = true;
+        auto parser = std::make_shared<program_options_heavy::Parser>("exename");
+        auto options = std::make_shared<OptionsGroup>("lazy group");
+        options->addPartialVisible("lazy-option,l", po::bool_switch(), "some switch");
+        parser->addGroup(options);
+        return parser;
+    });
+    Completer completer(commands_parser);
+    ASSERT_EQ(completer.getCompletionVariants("exename l"), (std::vector<std::string>{"lazy"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename run --d"), (std::vector<std::string>{"--dim"}));
+    ASSERT_FALSE(built);
+    ASSERT_EQ(completer.getCompletionVariants("exename lazy -"), (std::vector<std::string>{"--lazy-option"}));
+    ASSERT_TRUE(built);
+}
+
+TEST_F(CompleterFixture, ValueCompletion) {
+    namespace completion = program_options_heavy::completion;
+    auto modeOptions = std::make_shared<OptionsGroup>("mode group");
+    modeOptions->addPartialVisible("mode", po::value<std::string>(), "mode");
+    modeOptions->addPartialVisible("input,i", po::value<std::string>(), "input file");
+    modeOptions->addPartialVisible("count", po::value<size_t>(), "count");
+    modeOptions->setValueCompleter("mode", std::make_shared<completion::EnumValues>(
+        std::vector<std::string>{"fast", "slow", "fastest"}));
+    modeOptions->setValueCompleter("count", std::make_shared<completion::CallbackValues>(
+        [](std::string_view prefix, const completion::ValueCompleter::emit_t& emit) {
+            for(size_t n = 0; emit(std::string(prefix) + std::to_string(n)); n++);
+        }));
+
+    auto dir = std::filesystem::temp_directory_path() / ("poheavy_values_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir / "subdir");
+    for(size_t n = 0; n < 1000; n++)
+        std::ofstream(dir / ("file" + std::to_string(n) + ".txt"));
+    std::ofstream(dir / "other.txt");
+    modeOptions->setValueCompleter("input", std::make_shared<completion::PathValues>());
+    (*commands_parser)["run"]->addGroup(modeOptions);
+
+    Completer completer(commands_parser);
+    completer.setMaxValueCandidates(10);
+    auto sorted = [](std::vector<std::string> v) { std::sort(v.begin(), v.end()); return v; };
+    ASSERT_EQ(sorted(completer.getCompletionVariants("exename run --mode f")), (std::vector<std::string>{"fast", "fastest"}));
+    ASSERT_EQ(sorted(completer.getCompletionVariants("exename run --mode ")), (std::vector<std::string>{"fast", "fastest", "slow"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename run --mode=s"), (std::vector<std::string>{"--mode=slow"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename run --count 1").size(), 10); // the generator is cut off
+    ASSERT_EQ(completer.getCompletionVariants("exename run --mode fast --mo"), (std::vector<std::string>{}));
+    ASSERT_EQ(completer.getCompletionVariants("exename run --dim 1 --mo"), (std::vector<std::string>{"--mode"}));
+    // the completer keeps the value completers after the group is changed
+    modeOptions->setValueCompleter("mode", nullptr);
+    ASSERT_EQ(sorted(completer.getCompletionVariants("exename run --mode f")), (std::vector<std::string>{"fast", "fastest"}));
+
+    std::string prefix = dir.string() + "/";
+    ASSERT_EQ(completer.getCompletionVariants("exename run -i " + prefix + "o"), (std::vector<std::string>{prefix + "other.txt"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename run -i " + prefix + "s"), (std::vector<std::string>{prefix + "subdir/"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename run -i " + prefix + "file").size(), 10);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(VALUECOMPLETER, PathsWithDanglingSymlinks) {
+    auto dir = std::filesystem::temp_directory_path() / ("poheavy_links_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    std::vector<std::string> expected;
+    for(size_t n = 0; n < 50; n++) {
+        std::filesystem::create_symlink(dir / "missing", dir / ("link" + std::to_string(n)));
+        std::ofstream(dir / ("file" + std::to_string(n)));
+        expected.push_back(dir.string() + "/file" + std::to_string(n));
+        expected.push_back(dir.string() + "/link" + std::to_string(n));
+    }
+    auto received = program_options_heavy::completion::PathValues().candidates(dir.string() + "/", 1000);
+    std::sort(received.begin(), received.end());
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(received, expected);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_F(CompleterFixture, NestedSubcommands) {
+    bool storage_built = false;
+    auto node = commands_parser->addBranch("cluster", "manage the cluster")->addBranch("node", "manage the nodes");
+    auto drainOptions = std::make_shared<OptionsGroup>("drain group");
+    drainOptions->addPartialVisible("force,f", po::bool_switch(), "do not wait for the tasks");
+    drainOptions->addPartialVisible("timeout,t", po::value<size_t>(), "seconds to wait");
+    (*node)["drain"]->addGroup(drainOptions);
+    (*node)["list"];
+    commands_parser->addLazyBranch("storage", "manage the storage", [&storage_built]() {
+        storage_built = true;
+        auto storage = std::make_shared<ParserWithSubcommands>();
+        (*storage)["list"];
+        return storage;
+    });
+    Completer completer(commands_parser);
+    ASSERT_EQ(completer.getCompletionVariants("exename cl"), (std::vector<std::string>{"cluster"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster n"), (std::vector<std::string>{"node"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster node "), (std::vector<std::string>{"drain", "list"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster node drain --f"), (std::vector<std::string>{"--force"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster node drain -f "), (std::vector<std::string>{"--timeout"}));
+    ASSERT_FALSE(storage_built);
+    ASSERT_EQ(completer.getCompletionVariants("exename storage l"), (std::vector<std::string>{"list"}));
+    ASSERT_TRUE(storage_built);
+}
+
+TEST_F(CompleterFixture, CacheValuesOmitted) {
+    namespace completion = program_options_heavy::completion;
+    auto modeOptions = std::make_shared<OptionsGroup>("mode group");
+    modeOptions->addPartialVisible("mode", po::value<std::string>(), "mode");
+    modeOptions->setValueCompleter("mode", std::make_shared<completion::EnumValues>(std::vector<std::string>{"fast", "slow"}));
+    (*commands_parser)["run"]->addGroup(modeOptions);
+
+    auto path = std::filesystem::temp_directory_path() / ("poheavy_completer_test_" + std::to_string(getpid()) + ".idx");
+    completion::CompletionCache cache(path);
+    ASSERT_TRUE(Completer(commands_parser).saveCache(cache));
+    uint32_t flags = 0;
+    ASSERT_TRUE(cache.load(completion::ExecutableIdentity::current().value(), &flags).has_value());
+    ASSERT_EQ(flags, completion::CompletionCache::values_omitted);
+
+    // the names are answered by the cache, the values by the full completer
+    setenv("COMP_LINE", "exename run --mo", 1);
+    ASSERT_EQ(Completer::completeFromCache(cache), (std::vector<std::string>{"--mode"}));
+    setenv("COMP_LINE", "exename run --mode f", 1);
+    ASSERT_FALSE(Completer::completeFromCache(cache).has_value());
+    setenv("COMP_LINE", "exename run --mode=f", 1);
+    ASSERT_FALSE(Completer::completeFromCache(cache).has_value());
+    unsetenv("COMP_LINE");
+    std::filesystem::remove(path);
+}
+
+TEST_F(CompleterFixture, CacheNestedSubcommands) {
+    using program_options_heavy::completion::CompletionCache;
+    using program_options_heavy::completion::ExecutableIdentity;
+    auto node = commands_parser->addBranch("cluster", "manage the cluster")->addBranch("node", "manage the nodes");
+    auto drainOptions = std::make_shared<OptionsGroup>("drain group");
+    drainOptions->addPartialVisible("force,f", po::bool_switch(), "do not wait for the tasks");
+    drainOptions->addPartialVisible("timeout,t", po::value<size_t>(), "seconds to wait");
+    (*node)["drain"]->addGroup(drainOptions);
+    (*node)["list"];
+    commands_parser->addBranch("clean", "remove the data");
+
+    auto path = std::filesystem::temp_directory_path() / ("poheavy_completer_test_" + std::to_string(getpid()) + ".idx");
+    CompletionCache cache(path);
+    ASSERT_TRUE(Completer(commands_parser).saveCache(cache));
+    auto index = cache.load(ExecutableIdentity::current().value());
+    std::filesystem::remove(path);
+    ASSERT_TRUE(index.has_value());
+    Completer completer(std::move(index.value()));
+
+    ASSERT_EQ(completer.getCompletionVariants("exename cl"), (std::vector<std::string>{"clean", "cluster"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster"), (std::vector<std::string>{"cluster"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster "), (std::vector<std::string>{"node"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster node "), (std::vector<std::string>{"drain", "list"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster node d"), (std::vector<std::string>{"drain"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster node drain --"),
+              (std::vector<std::string>{"--force", "--timeout"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename cluster node drain -f "), (std::vector<std::string>{"--timeout"}));
+    ASSERT_EQ(completer.getCompletionVariants("exename run --d"), (std::vector<std::string>{"--dim"}));
+}
+
+TEST(COMPLETIONPROTOCOL, LineToPoint) {
+    using program_options_heavy::completion::CompletionProtocol;
+    ASSERT_EQ(CompletionProtocol::lineToPoint("exename run --dim", "11"), "exename run");
+    // COMP_POINT counts the characters: "é" and "ж" take two bytes each
+    ASSERT_EQ(CompletionProtocol::lineToPoint("exename --name=éж --dim", "17"), "exename --name=éж");
+    ASSERT_EQ(CompletionProtocol::lineToPoint("exename run", "100"), "exename run");
+    ASSERT_EQ(CompletionProtocol::lineToPoint("exename run", "x"), "exename run");
+    ASSERT_EQ(CompletionProtocol::lineToPoint("exename run", ""), "exename run");
+    auto request = CompletionProtocol::parseRequest("POHC1 -\n9\nexename é run");
+    ASSERT_TRUE(request.has_value());
+    ASSERT_EQ(request->line, "exename é");
+}
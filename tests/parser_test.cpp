@@ -0,0 +1,622 @@
+#include <ProgramOptionsHeavy.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace po = boost::program_options;
+using program_options_heavy::OptionsGroup;
+using program_options_heavy::Parser;
+using program_options_heavy::ResponseFileError;
+using program_options_heavy::ResponseFileOptions;
+
+TEST(PARSER, TOKENIZE) {
+    Parser parser("programname");
+    auto grp = std::make_shared<OptionsGroup>("group");
+    size_t dim = 0;
+    std::string name;
+    bool verbose = false;
+    bool quiet = false;
+    std::vector<int> list;
+    std::vector<std::string> inputs;
+    grp->addPartialVisible("dim,d", po::value<size_t>(&dim)->default_value(2), "dimension");
+    grp->addPartialVisible("name,n", po::value<std::string>(&name), "name");
+    grp->addPartialVisible("verbose,v", po::bool_switch(&verbose), "verbose");
+    grp->addPartialVisible("quiet,q", po::bool_switch(&quiet), "quiet");
+    grp->addPartialVisible("list", po::value<std::vector<int>>(&list)->multitoken(), "list");
+    grp->addPositionalVisible("input", -1, po::value<std::vector<std::string>>(&inputs), "inputs");
+    parser.addGroup(grp);
+
+    std::string big(1 << 20, 'x');
+    const char* argv1[] = {"prgmname", "a.txt", "--name=first", "-vq", "-d10", "b.txt", "--", "-c.txt"};
+    parser.parse(8, argv1);
+    ASSERT_EQ(dim, 10);
+    ASSERT_EQ(name, "first");
+    ASSERT_TRUE(verbose);
+    ASSERT_TRUE(quiet);
+    ASSERT_EQ(inputs, (std::vector<std::string>{"a.txt", "b.txt", "-c.txt"}));
+
+    inputs.clear();
+    const char* argv2[] = {"prgmname", "-n", big.c_str(), "--dim", "3", "-v"};
+    parser.parse(6, argv2);
+    ASSERT_EQ(name, big);
+    ASSERT_EQ(dim, 3);
+    ASSERT_TRUE(inputs.empty());
+
+    // handled by boost: multitoken option, abbreviation, value starting with '-'
+    const char* argv3[] = {"prgmname", "--list", "1", "2", "3", "--na", "-x-", "in.txt"};
+    parser.parse(8, argv3);
+    ASSERT_EQ(list, (std::vector<int>{1, 2, 3}));
+    ASSERT_EQ(name, "-x-");
+    ASSERT_EQ(inputs, std::vector<std::string>{"in.txt"});
+    ASSERT_EQ(dim, 2);
+
+    const char* argv4[] = {"prgmname", "--unknown", "1"};
+    ASSERT_THROW(parser.parse(3, argv4), po::unknown_option);
+    const char* argv5[] = {"prgmname", "--dim", "1", "-d", "2"};
+    ASSERT_THROW(parser.parse(5, argv5), po::multiple_occurrences);
+    const char* argv6[] = {"prgmname", "--dim", "abc"};
+    ASSERT_THROW(parser.parse(3, argv6), po::invalid_option_value);
+}
+
+TEST(PARSER, RESPONSEFILES) {
+    Parser parser("programname");
+    auto grp = std::make_shared<OptionsGroup>("group");
+    size_t dim = 0;
+    std::string name;
+    std::vector<std::string> inputs;
+    grp->addPartialVisible("dim,d", po::value<size_t>(&dim), "dimension");
+    grp->addPartialVisible("name,n", po::value<std::string>(&name), "name");
+    grp->addPositionalVisible("input", -1, po::value<std::vector<std::string>>(&inputs), "inputs");
+    parser.addGroup(grp);
+
+    auto dir = std::filesystem::temp_directory_path() / ("poheavy_rsp_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    auto write = [&dir](const std::string& name, const std::string& text) {
+        std::ofstream(dir / name, std::ios::binary) << text;
+        return "@" + (dir / name).string();
+    };
+    auto inner = write("inner.rsp", "c.txt\n'd e.txt'");
+    auto outer = write("outer.rsp", "--dim 5 a.txt \"--name=x y\"\n" + inner + " b\\ c.txt");
+
+    const char* argv1[] = {"prgmname", outer.c_str(), "last.txt"};
+    parser.parse(3, argv1); // disabled by default
+    ASSERT_EQ(inputs, (std::vector<std::string>{outer, "last.txt"}));
+    inputs.clear();
+    parser.enableResponseFiles();
+    parser.parse(3, argv1);
+    ASSERT_EQ(dim, 5);
+    ASSERT_EQ(name, "x y");
+    ASSERT_EQ(inputs, (std::vector<std::string>{"a.txt", "c.txt", "d e.txt", "b c.txt", "last.txt"}));
+
+    auto nul = write("nul.rsp", std::string("-n\0with space\0\0f.txt\0", 21) + inner);
+    parser.enableResponseFiles({ResponseFileOptions::Delimiter::Nul});
+    inputs.clear();
+    const char* argv2[] = {"prgmname", nul.c_str()};
+    parser.parse(2, argv2);
+    ASSERT_EQ(name, "with space");
+    ASSERT_EQ(inputs, (std::vector<std::string>{"", "f.txt", inner})); // taken literally
+
+    parser.enableResponseFiles();
+    auto self = write("self.rsp", "x.txt @" + (dir / "self.rsp").string());
+    const char* argv3[] = {"prgmname", self.c_str()};
+    try {
+        parser.parse(2, argv3);
+        FAIL();
+    } catch(const ResponseFileError& e) {
+        ASSERT_EQ(e.offset, 6);
+        ASSERT_EQ(e.path, (dir / "self.rsp").string());
+    }
+
+    auto broken = write("broken.rsp", "a.txt 'b.txt");
+    const char* argv4[] = {"prgmname", broken.c_str()};
+    try {
+        parser.parse(2, argv4);
+        FAIL();
+    } catch(const ResponseFileError& e) {
+        ASSERT_EQ(e.offset, 6);
+    }
+    auto missing = write("missing.rsp", "a.txt @" + (dir / "none.rsp").string());
+    const char* argv5[] = {"prgmname", missing.c_str()};
+    ASSERT_THROW(parser.parse(2, argv5), ResponseFileError);
+    auto none = "@" + (dir / "none.rsp").string();
+    const char* argv6[] = {"prgmname", none.c_str()};
+    ASSERT_THROW(parser.parse(2, argv6), ResponseFileError);
+
+    // the arguments after "--" are taken literally
+    auto ends = write("ends.rsp", "e.txt -- " + outer);
+    inputs.clear();
+    const char* argv7[] = {"prgmname", ends.c_str(), none.c_str()};
+    parser.parse(3, argv7);
+    ASSERT_EQ(inputs, (std::vector<std::string>{"e.txt", outer, none}));
+    inputs.clear();
+    const char* argv8[] = {"prgmname", inner.c_str(), "--", "@literal"};
+    parser.parse(4, argv8);
+    ASSERT_EQ(inputs, (std::vector<std::string>{"c.txt", "d e.txt", "@literal"}));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(PARSER, POSITIONALSINK) {
+    Parser parser("programname");
+    auto grp = std::make_shared<OptionsGroup>("group");
+    size_t dim = 0;
+    std::vector<std::string> received;
+    auto sink = std::make_shared<program_options_heavy::PositionalSink>(
+        [&received, &dim](std::string_view value) { received.emplace_back(std::to_string(dim) + ":" + std::string(value)); });
+    std::stringstream input(std::string("x.txt\0y z.txt\0", 14));
+    sink->setInput(input);
+    grp->addPartialVisible("dim,d", po::value<size_t>(&dim), "dimension");
+    grp->addPositionalSink("input", sink, "inputs", true);
+    parser.addGroup(grp);
+
+    // a.txt is pushed before the options are stored, the values from "-" on
+    // after them
+    const char* argv1[] = {"prgmname", "a.txt", "-", "-0", "--dim", "3", "b.txt"};
+    parser.parse(7, argv1);
+    ASSERT_EQ(received, (std::vector<std::string>{"0:a.txt", "3:x.txt", "3:y z.txt", "3:b.txt"}));
+
+    // parsed by boost because of the abbreviation
+    received.clear();
+    input.clear();
+    input.str("u.txt\nv.txt\n");
+    const char* argv2[] = {"prgmname", "-", "--di", "4", "c.txt"};
+    parser.parse(5, argv2);
+    ASSERT_EQ(received, (std::vector<std::string>{"4:u.txt", "4:v.txt", "4:c.txt"}));
+    // a.txt is streamed before the parser falls back to boost, not twice
+    received.clear();
+    const char* argv4[] = {"prgmname", "a.txt", "--di", "4", "b.txt"};
+    parser.parse(5, argv4);
+    ASSERT_EQ(received, (std::vector<std::string>{"4:a.txt", "4:b.txt"}));
+
+    // the config file does not feed the sink
+    auto path = std::filesystem::temp_directory_path() / ("poheavy_sink_" + std::to_string(getpid()) + ".ini");
+    std::ofstream(path) << "dim = 5\ninput = z.txt\n";
+    program_options_heavy::ConfigSources sources;
+    sources.config_file = path;
+    parser.setConfigSources(sources);
+    received.clear();
+    const char* argv3[] = {"prgmname", "d.txt"};
+    parser.parse(2, argv3);
+    std::filesystem::remove(path);
+    ASSERT_EQ(dim, 5);
+    ASSERT_EQ(received, (std::vector<std::string>{"4:d.txt"})); // pushed before the options are stored
+    ASSERT_EQ(parser.values().count("input"), 0);
+
+    ASSERT_THROW(program_options_heavy::PositionalSink(nullptr), std::invalid_argument);
+}
+
+TEST(PARSER, POSITIONALQUEUE) {
+    Parser parser("programname");
+    auto grp = std::make_shared<OptionsGroup>("group");
+    auto queue = std::make_shared<program_options_heavy::PositionalQueue>(4);
+    std::stringstream input;
+    for(size_t n = 0; n < 1000; n++) {
+        input << n << "\n";
+    }
+    queue->setInput(input);
+    grp->addPositionalSink("input", queue, "inputs");
+    parser.addGroup(grp);
+
+    size_t sum = 0;
+    size_t count = 0;
+    std::thread consumer([&]() {
+        while(auto value = queue->pop()) {
+            sum += std::stoul(value.value());
+            count++;
+        }
+    });
+    const char* argv1[] = {"prgmname", "-", "1000"};
+    parser.parse(3, argv1);
+    consumer.join();
+    ASSERT_EQ(count, 1001);
+    ASSERT_EQ(sum, 1000 * 999 / 2 + 1000);
+
+    const char* argv2[] = {"prgmname", "--unknown"};
+    std::thread consumer2([&]() { while(queue->pop()); });
+    ASSERT_THROW(parser.parse(2, argv2), po::unknown_option);
+    consumer2.join(); // the queue is closed on errors too
+}
+
+TEST(PARSER, CONFIGSOURCES) {
+    Parser parser("/usr/bin/my-tool");
+    auto grp = std::make_shared<OptionsGroup>("group");
+    size_t threads = 0;
+    size_t buffer = 0;
+    size_t port = 0;
+    size_t queue = 0;
+    std::string name;
+    grp->addPartialVisible("threads", po::value<size_t>(&threads)->default_value(1), "threads");
+    grp->addPartialVisible("queue_size", po::value<size_t>(&queue)->default_value(1), "queue size");
+    grp->addPartialVisible("buffer-size", po::value<size_t>(&buffer)->default_value(1), "buffer size");
+    grp->addPartialVisible("net.port", po::value<size_t>(&port)->required(), "port");
+    grp->addPartialVisible("name", po::value<std::string>(&name)->default_value("none"), "name");
+    parser.addGroup(grp);
+
+    auto path = std::filesystem::temp_directory_path() / ("poheavy_cfg_" + std::to_string(getpid()) + ".ini");
+    std::ofstream(path) << "# tunables\nthreads = 4\nbuffer-size=8 # bytes\n[net]\nport = 80\n";
+    ASSERT_EQ(program_options_heavy::ConfigSources::environmentPrefix("/usr/bin/my-tool"), "MY_TOOL_");
+    setenv("MY_TOOL_BUFFER_SIZE", "16", 1);
+    setenv("MY_TOOL_NET__PORT", "8080", 1);
+    setenv("MY_TOOL_UNRELATED", "x", 1);
+    setenv("MY_TOOL_QUEUE_SIZE", "32", 1);
+
+    program_options_heavy::ConfigSources sources;
+    sources.config_file = path;
+    sources.use_environment = true;
+    parser.setConfigSources(sources);
+    const char* argv1[] = {"prgmname", "--net.port", "443"};
+    parser.parse(3, argv1);
+    ASSERT_EQ(threads, 4);   // config file
+    ASSERT_EQ(buffer, 16);   // environment over config file
+    ASSERT_EQ(queue, 32);    // underscore kept in the name
+    ASSERT_EQ(port, 443);    // command line over environment
+    ASSERT_EQ(name, "none"); // default
+
+    const char* argv2[] = {"prgmname"};
+    parser.parse(1, argv2);
+    ASSERT_EQ(port, 8080);
+
+    std::ofstream(path) << "threads = 4\nunknown = 1\n";
+    ASSERT_THROW(parser.parse(1, argv2), po::unknown_option);
+    std::ofstream(path) << "threads\n";
+    ASSERT_THROW(parser.parse(1, argv2), po::invalid_config_file_syntax);
+    std::filesystem::remove(path);
+    parser.parse(1, argv2); // missing config file is not an error
+    ASSERT_EQ(threads, 1);
+
+    unsetenv("MY_TOOL_NET__PORT");
+    parser.parse(1, argv2); // the environment is scanned once
+    ASSERT_EQ(port, 8080);
+    parser.rescanEnvironment();
+    ASSERT_THROW(parser.parse(1, argv2), po::required_option);
+    unsetenv("MY_TOOL_BUFFER_SIZE");
+    unsetenv("MY_TOOL_UNRELATED");
+    unsetenv("MY_TOOL_QUEUE_SIZE");
+}
+
+TEST(PARSER, HOTRELOAD) {
+    struct Tunables {
+        size_t threads;
+        size_t buffer;
+    };
+    class Limits : public OptionsGroup {
+    public:
+        Limits() : OptionsGroup("limits") {
+            addPartialVisible("threads", po::value<size_t>(&threads)->default_value(1), "threads");
+        }
+        void validate() override {
+            if(threads == 0)
+                throw std::runtime_error("threads must be positive");
+        }
+        size_t threads;
+    };
+    auto parser = std::make_shared<Parser>("programname");
+    auto limits = std::make_shared<Limits>();
+    auto buffers = std::make_shared<OptionsGroup>("buffers");
+    size_t buffer = 0;
+    buffers->addPartialVisible("buffer", po::value<size_t>(&buffer)->default_value(1), "buffer");
+    parser->addGroup(limits);
+    parser->addGroup(buffers);
+
+    const char* no_file_argv[] = {"prgmname"};
+    ASSERT_THROW(program_options_heavy::HotReload<Tunables>(parser, 1, no_file_argv, {}, []() { return Tunables{}; }),
+                 std::runtime_error);
+
+    auto dir = std::filesystem::temp_directory_path() / ("poheavy_reload_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    auto path = dir / "options.ini";
+    std::ofstream(path) << "threads = 2\nbuffer = 10\n";
+    program_options_heavy::ConfigSources sources;
+    sources.config_file = path;
+    const char* argv[] = {"prgmname"};
+    program_options_heavy::HotReload<Tunables> reload(parser, 1, argv, sources,
+        [&]() { return Tunables{limits->threads, buffer}; });
+    ASSERT_EQ(reload.current()->threads, 2);
+    ASSERT_EQ(reload.snapshot().buffer, 10);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> changed;
+    size_t errors = 0;
+    reload.onGroupChanged([&](OptionsGroup& grp) {
+        std::lock_guard lock(mutex);
+        changed.push_back(grp.groupName());
+        cv.notify_all();
+    });
+    reload.onError([&](const std::exception&) {
+        std::lock_guard lock(mutex);
+        errors++;
+        cv.notify_all();
+    });
+    reload.start();
+
+    std::ofstream(dir / "options.tmp") << "threads = 2\nbuffer = 20\n";
+    std::filesystem::rename(dir / "options.tmp", path);
+    {
+        std::unique_lock lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return !changed.empty(); }));
+        ASSERT_EQ(changed, std::vector<std::string>{"buffers"});
+    }
+    ASSERT_EQ(reload.current()->buffer, 20);
+    ASSERT_EQ(reload.snapshot().buffer, 20);
+
+    std::ofstream(path) << "threads = 0\nbuffer = 30\n";
+    {
+        std::unique_lock lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return errors > 0; }));
+    }
+    ASSERT_EQ(reload.current()->threads, 2); // the invalid options are not published
+    ASSERT_EQ(reload.snapshot().buffer, 20);
+    ASSERT_EQ(limits->threads, 2); // nor left in the destinations
+    ASSERT_EQ(buffer, 20);
+    reload.stop();
+    std::filesystem::remove_all(dir);
+}
+
+TEST(PARSER, SUGGESTIONS) {
+    program_options_heavy::EditDistance distance("gather", 2);
+    ASSERT_EQ(distance("gather"), 0);
+    ASSERT_EQ(distance("gahter"), 2);
+    ASSERT_EQ(distance("gathr"), 1);
+    ASSERT_EQ(distance("xgatherx"), 2);
+    ASSERT_EQ(distance("run"), 3);
+    ASSERT_EQ(distance("completely-different"), 3);
+    std::string long_query(100, 'a');
+    program_options_heavy::EditDistance long_distance(long_query, 5);
+    ASSERT_EQ(long_distance(std::string(98, 'a') + "bb"), 2);
+
+    std::vector<std::string> names;
+    for(size_t n = 0; n < 20000; n++) {
+        names.push_back("option-" + std::to_string(n));
+    }
+    names.push_back("threads");
+    // the time is measured by BM_Suggestions
+    ASSERT_EQ(program_options_heavy::suggestions("thraeds", names), std::vector<std::string>{"threads"});
+
+    Parser parser("programname");
+    auto grp = std::make_shared<OptionsGroup>("group");
+    size_t threads;
+    grp->addPartialVisible("threads,t", po::value<size_t>(&threads), "threads");
+    grp->addPartialVisible("buffer-size", po::value<size_t>(&threads), "buffer size");
+    parser.addGroup(grp);
+    const char* argv1[] = {"prgmname", "--thraeds", "1"};
+    try {
+        parser.parse(3, argv1);
+        FAIL();
+    } catch(const po::unknown_option& e) {
+        ASSERT_NE(std::string(e.what()).find("Did you mean '--threads'?"), std::string::npos) << e.what();
+    }
+
+    program_options_heavy::ParserWithSubcommands subcommands_parser("programname");
+    subcommands_parser["gather"]->addGroup(grp);
+    subcommands_parser["run"];
+    const char* argv2[] = {"prgmname", "gahter"};
+    try {
+        subcommands_parser.parse(2, argv2);
+        FAIL();
+    } catch(const program_options_heavy::UnknownSubcommand& e) {
+        ASSERT_EQ(e.suggestions, std::vector<std::string>{"gather"});
+        ASSERT_NE(std::string(e.what()).find("Did you mean 'gather'?"), std::string::npos);
+    }
+}
+
+TEST(PARSER, PARSESTATS) {
+    using program_options_heavy::ParseStats;
+    using program_options_heavy::ParserWithSubcommands;
+    using Phase = ParseStats::Phase;
+    if (!ParseStats::enabled)
+        GTEST_SKIP() << "built with PROGRAM_OPTIONS_HEAVY_PARSE_STATS=OFF";
+    ParserWithSubcommands subcommands("programname");
+    auto first = std::make_shared<OptionsGroup>("first");
+    auto second = std::make_shared<OptionsGroup>("second");
+    size_t dim = 0;
+    size_t count = 0;
+    bool verbose = false;
+    first->addPartialVisible("dim,d", po::value<size_t>(&dim)->default_value(2), "dimension");
+    first->addPartialVisible("verbose,v", po::bool_switch(&verbose), "verbose");
+    second->addPartialVisible("count", po::value<size_t>(&count), "count");
+    subcommands["run"]->addGroup(first);
+    subcommands["run"]->addGroup(second);
+
+    auto stats = std::make_shared<ParseStats>();
+    uint64_t allocations = 0;
+    stats->setAllocationsCounter([&allocations]() { return allocations += 10; });
+    subcommands.setParseStats(stats);
+    const char *argv[] = {"programname", "run", "-v", "--count", "3"};
+    ASSERT_TRUE(subcommands.parse(5, argv));
+    subcommands.selectedSubcommand()->validate();
+
+    auto find = [&stats](Phase phase, std::string_view detail = {}) -> const ParseStats::Record * {
+        for (const auto &it : stats->records())
+            if (it.phase == phase && it.detail == detail)
+                return &it;
+        return nullptr;
+    };
+    ASSERT_NE(find(Phase::Dispatch, "run"), nullptr);
+    ASSERT_EQ(find(Phase::Tokenize)->options_matched, 2);
+    ASSERT_EQ(find(Phase::Update, "first")->options_matched, 1); // dim is defaulted
+    ASSERT_EQ(find(Phase::Update, "second")->options_matched, 1);
+    ASSERT_NE(find(Phase::Validate, "second"), nullptr);
+    ASSERT_EQ(find(Phase::Store)->allocations, 10);
+    ASSERT_EQ(find(Phase::ResponseFiles), nullptr);
+    size_t parses = 0;
+    for (const auto &it : stats->records())
+        parses += it.phase == Phase::Parse;
+    ASSERT_EQ(parses, 2); // both parsers
+    ASSERT_GE(stats->totalNanoseconds(Phase::Parse), stats->totalNanoseconds(Phase::Store));
+
+    // abbreviations are left to boost
+    const char *argv2[] = {"programname", "run", "--cou", "4"};
+    stats->clear();
+    ASSERT_TRUE(subcommands.parse(4, argv2));
+    ASSERT_EQ(count, 4);
+    ASSERT_EQ(find(Phase::Tokenize, "boost")->options_matched, 1);
+
+    stats->clear();
+    ASSERT_TRUE(subcommands.parse(5, argv));
+    std::string trace = stats->chromeTrace();
+    ASSERT_TRUE(trace.starts_with("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["));
+    ASSERT_NE(trace.find("{\"name\":\"update\",\"cat\":\"parse\",\"ph\":\"X\""), std::string::npos);
+    ASSERT_NE(trace.find("\"detail\":\"second\",\"options_matched\":1,\"allocations\":10}}"), std::string::npos);
+}
+
+TEST(PARSER, OPTIONSSCHEMA) {
+    auto grp = std::make_shared<OptionsGroup>("group");
+    size_t dim = 0;
+    grp->addPartialVisible("dimension,d", po::value<size_t>(&dim), "hypercube dimension");
+    grp->addPartialVisible("verbose", po::bool_switch(), "print more");
+    grp->addPartialVisible(",q", po::bool_switch(), "print less");
+    grp->setValueCompleter("dimension", std::make_shared<program_options_heavy::completion::EnumValues>(
+                                            std::vector<std::string>{"2", "3"}));
+
+    const auto& schema = grp->schema();
+    ASSERT_EQ(&schema, &grp->schema()); // built once
+    auto options = schema.options();
+    ASSERT_EQ(options.size(), 3);
+    ASSERT_EQ(options[0].long_name, "dimension");
+    ASSERT_EQ(std::vector<std::string_view>(options[0].names.begin(), options[0].names.end()),
+              (std::vector<std::string_view>{"--dimension", "-d"}));
+    ASSERT_EQ(options[0].description, "hypercube dimension");
+    ASSERT_NE(options[0].completer, nullptr);
+    ASSERT_EQ(options[1].names.size(), 1);
+    ASSERT_EQ(options[1].completer, nullptr);
+    ASSERT_EQ(options[2].long_name, "");
+    ASSERT_EQ(options[2].names.front(), "-q");
+    ASSERT_TRUE(schema.hasValueCompleters());
+
+    // the schema is rebuilt after the group is changed
+    grp->addPartialVisible("threads,j", po::value<size_t>(), "number of threads");
+    ASSERT_EQ(grp->schema().options().size(), 4);
+    ASSERT_EQ(grp->schema().options()[3].names.back(), "-j");
+}
+
+TEST(PARSER, TYPEDVALUES) {
+    using program_options_heavy::typedValue;
+    enum class Mode { Fast, Safe };
+    Parser parser("programname");
+    auto grp = std::make_shared<OptionsGroup>("group");
+    size_t dim = 0;
+    int offset = 0;
+    double ratio = 0;
+    bool check = false;
+    std::chrono::milliseconds timeout{};
+    std::chrono::duration<double> interval{};
+    Mode mode = Mode::Fast;
+    grp->addPartialVisible("dim,d", typedValue(&dim)->default_value(2), "hypercube dimension");
+    grp->addPartialVisible("offset", typedValue(&offset), "offset");
+    grp->addPartialVisible("ratio", typedValue(&ratio)->default_value(0.5), "ratio");
+    grp->addPartialVisible("check", typedValue(&check)->implicit_value(true), "check");
+    grp->addPartialVisible("timeout", typedValue(&timeout)->default_value(std::chrono::milliseconds(250)), "timeout");
+    grp->addPartialVisible("interval", typedValue(&interval), "interval");
+    grp->addPartialVisible("mode", program_options_heavy::enumValue(&mode, {{"fast", Mode::Fast}, {"safe", Mode::Safe}}),
+                           "mode");
+    parser.addGroup(grp);
+
+    const char* argv1[] = {"prgmname", "-d", "10", "--offset=-3", "--ratio", "1e-3", "--check", "--timeout", "2s",
+                           "--interval", "1.5min", "--mode", "safe"};
+    parser.parse(13, argv1);
+    ASSERT_EQ(dim, 10);
+    ASSERT_EQ(offset, -3);
+    ASSERT_EQ(ratio, 1e-3);
+    ASSERT_TRUE(check);
+    ASSERT_EQ(timeout, std::chrono::seconds(2));
+    ASSERT_EQ(interval.count(), 90);
+    ASSERT_EQ(mode, Mode::Safe);
+
+    const char* argv2[] = {"prgmname", "--check=no"};
+    parser.parse(2, argv2);
+    ASSERT_EQ(dim, 2);
+    ASSERT_FALSE(check);
+    ASSERT_EQ(timeout, std::chrono::milliseconds(250));
+
+    auto reason = [&parser](std::vector<const char*> argv) -> std::string {
+        argv.insert(argv.begin(), "prgmname");
+        try {
+            parser.parse(static_cast<int>(argv.size()), argv.data());
+        } catch (const program_options_heavy::InvalidValue& e) {
+            return e.reason();
+        }
+        return "";
+    };
+    ASSERT_EQ(reason({"-d", "12x"}), "unexpected character 'x' at position 2");
+    ASSERT_EQ(reason({"-d", "-1"}), "expected a non-negative integer");
+    ASSERT_EQ(reason({"--offset", "99999999999"}), "out of range [-2147483648, 2147483647]");
+    ASSERT_EQ(reason({"--timeout", "1500us"}), "not a whole number of the duration periods");
+    ASSERT_EQ(reason({"--timeout", "5"}), "missing unit (ns, us, ms, s, min, h, d)");
+    ASSERT_EQ(reason({"--timeout", "5sec"}), "unknown unit 'sec', expected ns, us, ms, s, min, h or d");
+    ASSERT_EQ(reason({"--mode", "slow"}), "expected one of fast|safe");
+    ASSERT_EQ(reason({"--check=maybe"}), "expected true, false, yes, no, on, off, 1 or 0");
+    ASSERT_THROW(parser.parse(3, std::vector<const char*>{"prgmname", "--ratio", "x"}.data()), po::invalid_option_value);
+
+    std::stringstream help;
+    help << grp->visible;
+    ASSERT_NE(help.str().find("--timeout arg (=250ms)"), std::string::npos);
+    ASSERT_NE(help.str().find("--ratio arg (=0.5)"), std::string::npos);
+    ASSERT_NE(help.str().find("--mode fast|safe"), std::string::npos);
+}
+
+TEST(PARSER, LISTVALUES) {
+    using program_options_heavy::listValue;
+    Parser parser("programname");
+    auto grp = std::make_shared<OptionsGroup>("group");
+    std::vector<uint32_t> ids;
+    std::vector<int64_t> offsets;
+    std::vector<double> weights;
+    std::array<uint16_t, 4> ports{};
+    size_t ports_count = 0;
+    grp->addPartialVisible("ids", listValue(&ids), "ids");
+    grp->addPartialVisible("offsets", listValue(&offsets, ':'), "offsets");
+    grp->addPartialVisible("weights", listValue(&weights), "weights");
+    grp->addPartialVisible("ports", listValue(std::span<uint16_t>(ports))->notifier([&ports_count](auto values) {
+        ports_count = values.size();
+    }), "ports");
+    parser.addGroup(grp);
+
+    // long numbers go through the 8-digit kernel
+    const char* argv1[] = {"prgmname", "--ids", "1,2,10-13,4294967295,123456789", "--offsets=-5--3:+7:-9223372036854775808",
+                           "--weights", "0.5,1e-3,-2", "--ports", "80,8080-8081"};
+    parser.parse(8, argv1);
+    ASSERT_EQ(ids, (std::vector<uint32_t>{1, 2, 10, 11, 12, 13, 4294967295, 123456789}));
+    ASSERT_EQ(offsets, (std::vector<int64_t>{-5, -4, -3, 7, std::numeric_limits<int64_t>::min()}));
+    ASSERT_EQ(weights, (std::vector<double>{0.5, 1e-3, -2}));
+    ASSERT_EQ(ports_count, 3);
+    ASSERT_EQ(ports, (std::array<uint16_t, 4>{80, 8080, 8081, 0}));
+
+    std::string many;
+    for (size_t n = 0; n < 100000; n++) {
+        many += (n ? "," : "") + std::to_string(n * 40009);
+    }
+    const char* argv2[] = {"prgmname", "--ids", many.c_str()};
+    parser.parse(3, argv2);
+    ASSERT_EQ(ids.size(), 100000);
+    ASSERT_EQ(ids[99999], 99999 * 40009u);
+
+    auto reason = [&parser](std::vector<const char*> argv) -> std::string {
+        argv.insert(argv.begin(), "prgmname");
+        try {
+            parser.parse(static_cast<int>(argv.size()), argv.data());
+        } catch (const program_options_heavy::InvalidValue& e) {
+            return e.reason();
+        }
+        return "";
+    };
+    ASSERT_EQ(reason({"--ids", "1,x"}), "expected a non-negative integer at position 2");
+    ASSERT_EQ(reason({"--ids", "1,,2"}), "empty value at position 2");
+    ASSERT_EQ(reason({"--ids", "1,"}), "empty value at position 2");
+    ASSERT_EQ(reason({"--ids", "1;2"}), "unexpected character ';' at position 1");
+    ASSERT_EQ(reason({"--ids", "4294967296"}), "out of range [0, 4294967295] at position 0");
+    ASSERT_EQ(reason({"--ids", "99999999999999999999999"}), "out of range [0, 4294967295] at position 0");
+    ASSERT_EQ(reason({"--ids", "5-3"}), "empty range at position 0");
+    ASSERT_EQ(reason({"--ports", "1-5"}), "more than 4 values at position 0");
+    ASSERT_EQ(reason({"--weights", "0.5-1"}), "unexpected character '-' at position 3");
+    ASSERT_EQ(reason({"--weights", "1,+-1.5"}), "expected a number at position 2");
+    // the huge ranges are rejected before they are filled
+    ASSERT_EQ(reason({"--ids", "7,0-4000000000"}), "more than 67108864 values at position 2");
+    ASSERT_LT(ids.capacity(), size_t(1) << 20);
+    ASSERT_EQ(reason({"--offsets", "-9223372036854775808-9223372036854775807"}), "more than 67108864 values at position 0");
+}
@@ -0,0 +1,69 @@
+#include <ProgramOptionsHeavy.h>
+#include <gtest/gtest.h>
+
+using program_options_heavy::printers::Document;
+using program_options_heavy::printers::OutputSink;
+using program_options_heavy::printers::PrettyPrinter;
+using program_options_heavy::printers::Section;
+using program_options_heavy::printers::StringSink;
+using program_options_heavy::printers::UnorderedList;
+
+namespace {
+
+class CountingSink : public OutputSink {
+public:
+    void write(std::string_view text) override {
+        writes++;
+        str.append(text);
+    }
+    bool isTerminal() const override {
+        return true;
+    }
+    size_t writes{0};
+    std::string str;
+};
+
+std::shared_ptr<Section> document() {
+    auto doc = Document::create();
+    auto res = doc->make<Section>();
+    res->title = std::string("Usage") + ":"; // the temporary is copied
+    res->add_paragraph("first line\nsecond line");
+    auto details = res->add<Section>();
+    details->setTitle(std::string("details"));
+    auto list = details->add<UnorderedList>();
+    list->add("one");
+    list->add(std::string("two"));
+    return doc->share(res);
+}
+
+}
+
+TEST(PRETTYPRINTER, RENDER) {
+    std::string str;
+    PrettyPrinter printer(std::make_shared<StringSink>(str), PrettyPrinter::ColorMode::Auto);
+    printer.print(document());
+    ASSERT_EQ(str, "\nUSAGE:\n    first line\n    second line\n\n  DETAILS\n      *one\n      *two\n");
+
+    auto sink = std::make_shared<CountingSink>();
+    PrettyPrinter tty_printer(sink);
+    document()->accept(tty_printer);
+    ASSERT_EQ(sink->writes, 1);
+    ASSERT_EQ(sink->str.substr(0, 16), "\n\033[1mUSAGE:\033[0m\n");
+
+    PrettyPrinter plain_printer(sink, PrettyPrinter::ColorMode::Never);
+    ASSERT_EQ(plain_printer.render(document()), str);
+    ASSERT_EQ(sink->writes, 1);
+}
+
+TEST(PRETTYPRINTER, MULTILINETITLE) {
+    auto doc = Document::create();
+    auto res = doc->make<Section>();
+    res->title = "Usage:\nprog";
+    auto details = res->add<Section>();
+    details->title = "first\nsecond";
+    std::string str;
+    PrettyPrinter printer(std::make_shared<StringSink>(str), PrettyPrinter::ColorMode::Always);
+    printer.print(doc->share(res));
+    ASSERT_EQ(str, "\n\033[1mUSAGE:\033[0m\n\033[1mPROG\033[0m\n"
+                   "\n  \033[1mFIRST\033[0m\n  \033[1mSECOND\033[0m\n");
+}
@@ -39,4 +39,294 @@ TEST(PROGRAMMODEOPTIONS, PARSE) {
             subcommands_parser.parse(6, argv3);
         },
     po::unknown_option);
-}
\ No newline at end of file
+}
+TEST(PROGRAMMODEOPTIONS, REPEATEDPARSE) {
+    namespace po = boost::program_options;
+    program_options_heavy::Parser parser("programname");
+    auto runOptions = std::make_shared<OptionsGroup>("run group");
+    size_t dim = 0;
+    std::vector<std::string> inputs;
+    runOptions->addPartialVisible("dimension,d", po::value<size_t>(&dim)->default_value(2), "hypercube dimension");
+    runOptions->addPositionalVisible("input", -1, po::value(&inputs), "input files");
+    parser.addGroup(runOptions);
+
+    const char* argv1[] = {"prgmname", "-d10", "a.txt", "b.txt"};
+    parser.parse(4, argv1);
+    ASSERT_EQ(dim, 10);
+    ASSERT_EQ(inputs, (std::vector<std::string>{"a.txt", "b.txt"}));
+
+    // abbreviations are resolved by boost
+    const char* argv2[] = {"prgmname", "--dimen", "5"};
+    parser.parse(3, argv2);
+    ASSERT_EQ(dim, 5);
+
+    // the merged description is rebuilt after addGroup
+    auto commonOptions = std::make_shared<OptionsGroup>("common group");
+    size_t common_value = 0;
+    commonOptions->addPartialVisible("common,c", po::value<size_t>(&common_value)->default_value(2), "common value");
+    parser.addGroup(commonOptions);
+    const char* argv3[] = {"prgmname", "-c", "20"};
+    parser.parse(3, argv3);
+    ASSERT_EQ(common_value, 20);
+    ASSERT_EQ(dim, 2);
+
+    const char* argv4[] = {"prgmname", "--unknown"};
+    EXPECT_THROW(parser.parse(2, argv4), po::unknown_option);
+}
+
+TEST(PROGRAMMODEOPTIONS, LAZYSUBCOMMANDS) {
+    namespace po = boost::program_options;
+    ParserWithSubcommands subcommands_parser("programname");
+    size_t dim = 0;
+    size_t gather_opt = 0;
+    size_t run_built = 0;
+    subcommands_parser.addLazy("run", "run the task", [&]() {
+        run_built++;
+        auto parser = std::make_shared<program_options_heavy::Parser>("programname");
+        auto runOptions = std::make_shared<OptionsGroup>("run group");
+        runOptions->addPartialVisible("dim,d", po::value<size_t>(&dim)->default_value(2), "hypercube dimension");
+        parser->addGroup(runOptions);
+        return parser;
+    });
+    auto gatherOptions = std::make_shared<OptionsGroup>("gather group");
+    gatherOptions->addPartialVisible("gather,g", po::value<size_t>(&gather_opt)->default_value(2), "some option for gathering");
+    subcommands_parser["gather"]->addGroup(gatherOptions);
+
+    const char* argv1[] = {"prgmname", "gather", "-g", "15"};
+    subcommands_parser.parse(4, argv1);
+    ASSERT_EQ(gather_opt, 15);
+    ASSERT_FALSE(subcommands_parser.isInstantiated("run"));
+    ASSERT_EQ(subcommands_parser.subcommandDescription("run"), "run the task");
+
+    ProgramSubcommandsPrinter printer;
+    printer.print(subcommands_parser);
+    ASSERT_EQ(run_built, 0);
+
+    const char* argv2[] = {"prgmname", "run", "-d", "10"};
+    subcommands_parser.parse(4, argv2);
+    subcommands_parser.parse(4, argv2);
+    ASSERT_EQ(dim, 10);
+    ASSERT_EQ(run_built, 1);
+    ASSERT_TRUE(subcommands_parser.isInstantiated("run"));
+    ASSERT_EQ(subcommands_parser.selectedSubcommand()->program_description, "run the task");
+}
+
+TEST(PROGRAMMODEOPTIONS, GETSUBCOMMANDS) {
+    ParserWithSubcommands subcommands_parser("programname");
+    subcommands_parser["gather"];
+    subcommands_parser.addLazy("run", "run the task", []() { return std::make_shared<program_options_heavy::Parser>("programname"); });
+    subcommands_parser.addBranch("storage", "manage the storage");
+
+    auto subcommands = subcommands_parser.getSubcommands();
+    ASSERT_EQ(subcommands.size(), 2); // the branches are not included
+    ASSERT_NE(subcommands.at("run"), nullptr);
+    ASSERT_TRUE(subcommands_parser.isInstantiated("run"));
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    auto& order = subcommands_parser.subcommandsOrder();
+    auto first = order[0];
+    // the repeated calls keep the iterators
+    ASSERT_EQ(&subcommands_parser.subcommandsOrder(), &order);
+    ASSERT_EQ(subcommands_parser.subcommandsOrder()[0], first);
+#pragma GCC diagnostic pop
+    ASSERT_EQ(order.size(), 2);
+    ASSERT_EQ(order[0]->first, "gather");
+    ASSERT_EQ(order[1]->first, "run");
+    ASSERT_EQ(order[1]->second, subcommands.at("run"));
+
+    // the printer overloads of the earlier versions
+    ProgramSubcommandsPrinter printer;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    ASSERT_EQ(printer.shortHelp(subcommands_parser, order[0]), "programname gather ");
+    ASSERT_EQ(printer.subcommandDescription(subcommands_parser, order[1]), "run - run the task");
+#pragma GCC diagnostic pop
+    auto gatherOptions = std::make_shared<OptionsGroup>("gather group");
+    subcommands_parser["gather"]->addGroup(gatherOptions);
+    auto sections = printer.print(*subcommands_parser["gather"]);
+    ASSERT_EQ(sections.size(), 1);
+    ASSERT_EQ(sections[0]->title, "gather group");
+    ASSERT_EQ(printer.print(*gatherOptions)->title, "gather group");
+
+    // the added subcommand is seen by the next call
+    subcommands_parser["collect"];
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    ASSERT_EQ(subcommands_parser.subcommandsOrder().size(), 3);
+    ASSERT_EQ(subcommands_parser.subcommandsOrder()[2]->first, "collect");
+#pragma GCC diagnostic pop
+}
+
+TEST(PROGRAMMODEOPTIONS, MANYSUBCOMMANDS) {
+    namespace po = boost::program_options;
+    ParserWithSubcommands subcommands_parser("programname");
+    std::vector<size_t> values(100);
+    for(size_t n = 0; n < values.size(); n++) {
+        auto grp = std::make_shared<OptionsGroup>("group" + std::to_string(n));
+        grp->addPartialVisible("value,v", po::value<size_t>(&values[n]), "value");
+        subcommands_parser["cmd" + std::to_string(n)]->addGroup(grp);
+    }
+    ASSERT_THROW(subcommands_parser.push_back("cmd10", nullptr), std::runtime_error);
+    ASSERT_EQ(subcommands_parser.subcommands().size(), 100);
+    ASSERT_EQ(subcommands_parser.subcommands()[42].name, "cmd42");
+
+    const char* argv1[] = {"prgmname", "cmd57", "-v", "7"};
+    subcommands_parser.parse(4, argv1);
+    ASSERT_EQ(subcommands_parser.selectedSubcommandName(), "cmd57");
+    ASSERT_EQ(values[57], 7);
+
+    const char* argv2[] = {"prgmname", "cmd100", "-v", "7"};
+    ASSERT_THROW(subcommands_parser.parse(4, argv2), std::runtime_error);
+}
+
+TEST(PROGRAMMODEOPTIONS, CONFIGSOURCES) {
+    namespace po = boost::program_options;
+    ParserWithSubcommands subcommands_parser("programname");
+    size_t dim = 0;
+    auto runOptions = std::make_shared<OptionsGroup>("run group");
+    runOptions->addPartialVisible("dim,d", po::value<size_t>(&dim)->default_value(2), "hypercube dimension");
+    subcommands_parser["run"]->addGroup(runOptions);
+    program_options_heavy::ConfigSources sources;
+    sources.use_environment = true;
+    subcommands_parser.setConfigSources(sources);
+
+    setenv("PROGRAMNAME_DIM", "7", 1);
+    const char* argv1[] = {"prgmname", "run"};
+    subcommands_parser.parse(2, argv1);
+    ASSERT_EQ(dim, 7);
+    unsetenv("PROGRAMNAME_DIM");
+}
+
+TEST(PROGRAMMODEOPTIONS, SUBCOMMANDHELP) {
+    namespace po = boost::program_options;
+    ParserWithSubcommands subcommands_parser("programname");
+    size_t dim;
+    size_t gather_opt;
+    subcommands_parser.addLazy("run", "run the task", [&dim]() {
+        auto parser = std::make_shared<program_options_heavy::Parser>("programname");
+        auto runOptions = std::make_shared<OptionsGroup>("run group");
+        runOptions->addPartialVisible("dim,d", po::value<size_t>(&dim)->default_value(2), "hypercube dimension");
+        parser->addGroup(runOptions);
+        return parser;
+    });
+    auto gatherOptions = std::make_shared<OptionsGroup>("gather group");
+    gatherOptions->addPartialVisible("gather,g", po::value<size_t>(&gather_opt)->default_value(2), "some option for gathering");
+    subcommands_parser["gather"]->addGroup(gatherOptions);
+    auto help = std::make_shared<program_options_heavy::HelpSubcommand>();
+    subcommands_parser.push_back("help", help);
+
+    const char* argv1[] = {"prgmname", "help", "run"};
+    subcommands_parser.parse(3, argv1);
+    ASSERT_EQ(help->topic(), "run");
+
+    ProgramSubcommandsPrinter printer;
+    auto section = printer.print(subcommands_parser, help->topic());
+    ASSERT_TRUE(subcommands_parser.isInstantiated("run"));
+    std::string text;
+    PrettyPrinter pretty(std::make_shared<program_options_heavy::printers::StringSink>(text), PrettyPrinter::ColorMode::Never);
+    pretty.print(section);
+    ASSERT_NE(text.find("--dim"), std::string::npos);
+    ASSERT_EQ(text.find("--gather"), std::string::npos);
+    ASSERT_NE(text.find("gather - "), std::string::npos);
+    ASSERT_EQ(printer.print(subcommands_parser, "run"), section);
+    ASSERT_THROW(printer.print(subcommands_parser, "unknown"), std::runtime_error);
+
+    const char* argv2[] = {"prgmname", "help"};
+    subcommands_parser.parse(2, argv2);
+    ASSERT_EQ(help->topic(), "");
+}
+
+TEST(PROGRAMMODEOPTIONS, SUBCOMMANDHELPOFTWOPARSERS) {
+    namespace po = boost::program_options;
+    size_t dim = 0;
+    size_t threads = 0;
+    ParserWithSubcommands first("first");
+    auto dimOptions = std::make_shared<OptionsGroup>("dim group");
+    dimOptions->addPartialVisible("dim,d", po::value<size_t>(&dim)->default_value(2), "hypercube dimension");
+    first["run"]->addGroup(dimOptions);
+    ParserWithSubcommands second("second");
+    auto threadsOptions = std::make_shared<OptionsGroup>("threads group");
+    threadsOptions->addPartialVisible("threads,t", po::value<size_t>(&threads)->default_value(1), "number of threads");
+    second["run"]->addGroup(threadsOptions);
+
+    // the same path of the different parsers is not taken from the cache
+    ProgramSubcommandsPrinter printer;
+    auto first_section = printer.print(first, "run");
+    auto second_section = printer.print(second, "run");
+    ASSERT_NE(first_section, second_section);
+    ASSERT_EQ(printer.print(first, "run"), first_section);
+    std::string text;
+    PrettyPrinter pretty(std::make_shared<program_options_heavy::printers::StringSink>(text), PrettyPrinter::ColorMode::Never);
+    pretty.print(second_section);
+    ASSERT_NE(text.find("--threads"), std::string::npos);
+    ASSERT_EQ(text.find("--dim"), std::string::npos);
+}
+
+TEST(PROGRAMMODEOPTIONS, NESTED) {
+    namespace po = boost::program_options;
+    ParserWithSubcommands subcommands_parser("programname");
+    bool force = false;
+    size_t timeout = 0;
+    size_t storage_built = 0;
+    auto cluster = subcommands_parser.addBranch("cluster", "manage the cluster");
+    auto node = cluster->addBranch("node", "manage the nodes");
+    auto drainOptions = std::make_shared<OptionsGroup>("drain group");
+    drainOptions->addPartialVisible("force,f", po::bool_switch(&force), "do not wait for the tasks");
+    drainOptions->addPartialVisible("timeout,t", po::value<size_t>(&timeout)->default_value(60), "seconds to wait");
+    (*node)["drain"]->addGroup(drainOptions);
+    (*node)["drain"]->program_description = "move the tasks off the node";
+    (*node)["list"];
+    (*cluster)["status"];
+    cluster->setDefaultSubcommand("status", false);
+    subcommands_parser.addLazyBranch("storage", "manage the storage", [&storage_built]() {
+        storage_built++;
+        auto storage = std::make_shared<ParserWithSubcommands>();
+        (*storage)["list"];
+        return storage;
+    });
+    auto help = std::make_shared<program_options_heavy::HelpSubcommand>();
+    subcommands_parser.push_back("help", help);
+
+    const char* argv1[] = {"prgmname", "cluster", "node", "drain", "-f", "--timeout", "5"};
+    subcommands_parser.parse(7, argv1);
+    ASSERT_TRUE(force);
+    ASSERT_EQ(timeout, 5);
+    ASSERT_EQ(subcommands_parser.selectedSubcommandName(), "cluster");
+    ASSERT_EQ(subcommands_parser.selectedPath(), "cluster node drain");
+    ASSERT_EQ(subcommands_parser.selectedSubcommand(), (*node)["drain"]);
+    ASSERT_EQ(storage_built, 0);
+    ASSERT_THROW(subcommands_parser.at("cluster"), std::runtime_error);
+
+    // the default subcommand of the nested level
+    const char* argv2[] = {"prgmname", "cluster"};
+    subcommands_parser.parse(2, argv2);
+    ASSERT_EQ(subcommands_parser.selectedPath(), "cluster status");
+
+    const char* argv3[] = {"prgmname", "cluster", "node", "drian"};
+    ASSERT_THROW(subcommands_parser.parse(4, argv3), program_options_heavy::UnknownSubcommand);
+
+    const char* argv4[] = {"prgmname", "storage", "list"};
+    subcommands_parser.parse(3, argv4);
+    ASSERT_EQ(subcommands_parser.selectedPath(), "storage list");
+    ASSERT_EQ(storage_built, 1);
+    ASSERT_EQ(subcommands_parser.branch("storage")->exename, "programname storage");
+
+    const char* argv5[] = {"prgmname", "help", "cluster", "node", "drain"};
+    subcommands_parser.parse(5, argv5);
+    ASSERT_EQ(help->topic(), "cluster node drain");
+
+    ProgramSubcommandsPrinter printer;
+    std::string text;
+    PrettyPrinter pretty(std::make_shared<program_options_heavy::printers::StringSink>(text), PrettyPrinter::ColorMode::Never);
+    pretty.print(printer.print(subcommands_parser, help->topic()));
+    ASSERT_NE(text.find("--timeout"), std::string::npos);
+    ASSERT_NE(text.find("programname cluster node drain"), std::string::npos);
+    ASSERT_NE(text.find("list - "), std::string::npos);
+    text.clear();
+    pretty.print(printer.print(subcommands_parser, "cluster"));
+    ASSERT_NE(text.find("programname cluster node <subcommand> ..."), std::string::npos);
+    ASSERT_NE(text.find("node - manage the nodes"), std::string::npos);
+    ASSERT_THROW(printer.print(subcommands_parser, "cluster drain"), std::runtime_error);
+    ASSERT_THROW(printer.print(subcommands_parser, "help cluster"), std::runtime_error);
+}
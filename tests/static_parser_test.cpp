@@ -0,0 +1,76 @@
+#include <Parsers/StaticParser.h>
+#include <gtest/gtest.h>
+
+namespace po = boost::program_options;
+using program_options_heavy::StaticOption;
+using program_options_heavy::StaticParser;
+using program_options_heavy::StaticSchema;
+
+using Schema = StaticSchema<StaticOption<"dim", 'd', size_t, "hypercube dimension">,
+                            StaticOption<"ratio", '\0', double, "some ratio">,
+                            StaticOption<"name", 'n', std::string, "the name">,
+                            StaticOption<"verbose", 'v', bool, "print more">>;
+
+static_assert(Schema::find("dim") == 0);
+static_assert(Schema::find("verbose") == 3);
+static_assert(!Schema::find("dimension").has_value());
+static_assert(Schema::findShort('n') == 2);
+static_assert(!Schema::findShort('r').has_value());
+
+TEST(STATICPARSER, PARSE) {
+    StaticParser<Schema> parser("programname");
+    const char* argv[] = {"programname", "-d", "10", "--ratio=0.5", "input.txt", "-nfoo", "-v", "--", "-d"};
+    parser.parse(9, argv);
+    ASSERT_EQ(parser.get<"dim">(), 10u);
+    ASSERT_EQ(parser.get<"ratio">(), 0.5);
+    ASSERT_EQ(parser.get<"name">(), std::string("foo"));
+    ASSERT_EQ(parser.get<"verbose">(), true);
+    ASSERT_EQ(parser.positional(), (std::vector<std::string_view>{"input.txt", "-d"}));
+}
+
+TEST(STATICPARSER, SHORTCLUSTERS) {
+    using Switches = StaticSchema<StaticOption<"dim", 'd', size_t>, StaticOption<"verbose", 'v', bool>,
+                                  StaticOption<"quiet", 'q', bool>>;
+    StaticParser<Switches> parser("programname");
+    const char* argv1[] = {"programname", "-vq"};
+    parser.parse(2, argv1);
+    ASSERT_TRUE(parser.get<"verbose">().value_or(false));
+    ASSERT_TRUE(parser.get<"quiet">().value_or(false));
+    const char* argv2[] = {"programname", "-qd10"};
+    parser.parse(2, argv2);
+    ASSERT_TRUE(parser.get<"quiet">().value_or(false));
+    ASSERT_EQ(parser.get<"dim">(), 10u);
+    const char* argv3[] = {"programname", "-vd", "20", "input.txt"};
+    parser.parse(4, argv3);
+    ASSERT_EQ(parser.get<"dim">(), 20u);
+    ASSERT_EQ(parser.positional(), (std::vector<std::string_view>{"input.txt"}));
+    const char* argv4[] = {"programname", "-vx"};
+    EXPECT_THROW(parser.parse(2, argv4), po::unknown_option);
+}
+
+TEST(STATICPARSER, ERRORS) {
+    StaticParser<Schema> parser("programname");
+    const char* argv1[] = {"programname", "--unknown", "1"};
+    EXPECT_THROW(parser.parse(3, argv1), po::unknown_option);
+    const char* argv2[] = {"programname", "--dim", "1x"};
+    EXPECT_THROW(parser.parse(3, argv2), po::invalid_option_value);
+    try {
+        parser.parse(3, argv2);
+    } catch (const po::invalid_option_value& e) {
+        EXPECT_EQ(e.get_option_name(), "--dim");
+        EXPECT_NE(std::string(e.what()).find("'--dim'"), std::string::npos);
+    }
+    const char* argv3[] = {"programname", "--dim"};
+    EXPECT_THROW(parser.parse(2, argv3), po::invalid_command_line_syntax);
+}
+
+TEST(STATICPARSER, MANYOPTIONS) {
+    using Big = StaticSchema<StaticOption<"a0", '\0', int>, StaticOption<"a1", '\0', int>, StaticOption<"a2", '\0', int>,
+                             StaticOption<"a3", '\0', int>, StaticOption<"a4", '\0', int>, StaticOption<"a5", '\0', int>,
+                             StaticOption<"a6", '\0', int>, StaticOption<"a7", '\0', int>, StaticOption<"a8", '\0', int>,
+                             StaticOption<"a9", '\0', int>, StaticOption<"b0", '\0', int>, StaticOption<"b1", '\0', int>>;
+    for (size_t n = 0; n < Big::size; n++) {
+        ASSERT_EQ(Big::find(Big::options[n].name), n);
+    }
+    ASSERT_FALSE(Big::find("b2").has_value());
+}